@@ -7,6 +7,18 @@ Mesh::Mesh(ID3D11Device* pDevice, const std::vector<Vertex>& _vertices, const st
 	, indices(_indices)
 	, m_pEffect{ pEffect }
 {
+	if (vertices.empty() == false)
+	{
+		boundsMin = vertices.front().position;
+		boundsMax = vertices.front().position;
+	}
+
+	for (const Vertex& vertex : vertices)
+	{
+		boundsMin = { std::min(boundsMin.x, vertex.position.x), std::min(boundsMin.y, vertex.position.y), std::min(boundsMin.z, vertex.position.z) };
+		boundsMax = { std::max(boundsMax.x, vertex.position.x), std::max(boundsMax.y, vertex.position.y), std::max(boundsMax.z, vertex.position.z) };
+	}
+
 	// Create Vertex Layout
 	static constexpr uint32_t numElements{ 5 };
 	D3D11_INPUT_ELEMENT_DESC vertexDesc[numElements]{};
@@ -120,3 +132,42 @@ void Mesh::DrawUsingDefaultTechnique(ID3D11DeviceContext* pDeviceContext) const
 	}
 
 }
+
+VertexOutBuffer::~VertexOutBuffer()
+{
+	::operator delete[](m_pData, std::align_val_t{ ALIGNMENT });
+}
+
+void VertexOutBuffer::Resize(size_t newSize)
+{
+	size = newSize;
+
+	if (newSize <= capacity)
+		return;
+
+	::operator delete[](m_pData, std::align_val_t{ ALIGNMENT });
+
+	capacity = (newSize + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+
+	// all components share one allocation, the padded capacity keeps every array aligned
+	constexpr size_t nrOfFloatArrays{ 15 };
+	constexpr size_t nrOfByteArrays{ 2 };
+	m_pData = ::operator new[](capacity * (nrOfFloatArrays * sizeof(float) + nrOfByteArrays), std::align_val_t{ ALIGNMENT });
+
+	float* pFloats = static_cast<float*>(m_pData);
+	float** floatArrays[nrOfFloatArrays]{
+		&pPositionX, &pPositionY, &pPositionZ, &pPositionW,
+		&pU, &pV,
+		&pNormalX, &pNormalY, &pNormalZ,
+		&pTangentX, &pTangentY, &pTangentZ,
+		&pViewDirectionX, &pViewDirectionY, &pViewDirectionZ };
+
+	for (float** ppArray : floatArrays)
+	{
+		*ppArray = pFloats;
+		pFloats += capacity;
+	}
+
+	pFrustumOutCodes = reinterpret_cast<uint8_t*>(pFloats);
+	pGuardBandOutCodes = pFrustumOutCodes + capacity;
+}
@@ -24,6 +24,179 @@ struct VertexOut
 	Vector3 normal;
 	Vector3 tangent;
 	Vector3 viewDirection;
+
+	static VertexOut Lerp(const VertexOut& v1, const VertexOut& v2, float factor)
+	{
+		VertexOut result{};
+		result.position = v1.position + (v2.position - v1.position) * factor;
+		result.color = ColorRGB::Lerp(v1.color, v2.color, factor);
+		result.uv = v1.uv + (v2.uv - v1.uv) * factor;
+		result.normal = v1.normal + (v2.normal - v1.normal) * factor;
+		result.tangent = v1.tangent + (v2.tangent - v1.tangent) * factor;
+		result.viewDirection = v1.viewDirection + (v2.viewDirection - v1.viewDirection) * factor;
+		return result;
+	}
+};
+
+// transformed vertices with one array per component, the vertex stage writes them by index
+// and the triangle stage fetches the vertices of a triangle through its indices, loading only what it needs
+struct VertexOutBuffer
+{
+	// every array is aligned to and padded up to a whole number of SIMD registers
+	static constexpr size_t SIMD_WIDTH{ 8 };
+	static constexpr size_t ALIGNMENT{ SIMD_WIDTH * sizeof(float) };
+
+	VertexOutBuffer() = default;
+	~VertexOutBuffer();
+
+	VertexOutBuffer(const VertexOutBuffer& other) = delete;
+	VertexOutBuffer& operator=(const VertexOutBuffer& rhs) = delete;
+	VertexOutBuffer(VertexOutBuffer&& other) = delete;
+	VertexOutBuffer& operator=(VertexOutBuffer&& rhs) = delete;
+
+	// only reallocates when the buffer has to grow, the contents are undefined afterwards
+	void Resize(size_t newSize);
+
+	// the color is not part of the stream, the software shading does not use it
+	VertexOut Fetch(uint32_t index) const
+	{
+		VertexOut vertexOut{};
+		vertexOut.position = { pPositionX[index], pPositionY[index], pPositionZ[index], pPositionW[index] };
+		vertexOut.uv = { pU[index], pV[index] };
+		vertexOut.normal = { pNormalX[index], pNormalY[index], pNormalZ[index] };
+		vertexOut.tangent = { pTangentX[index], pTangentY[index], pTangentZ[index] };
+		vertexOut.viewDirection = { pViewDirectionX[index], pViewDirectionY[index], pViewDirectionZ[index] };
+		return vertexOut;
+	}
+
+	size_t size{};
+	size_t capacity{};
+
+	// clip space
+	float* pPositionX{};
+	float* pPositionY{};
+	float* pPositionZ{};
+	float* pPositionW{};
+
+	float* pU{};
+	float* pV{};
+
+	float* pNormalX{};
+	float* pNormalY{};
+	float* pNormalZ{};
+
+	float* pTangentX{};
+	float* pTangentY{};
+	float* pTangentZ{};
+
+	float* pViewDirectionX{};
+	float* pViewDirectionY{};
+	float* pViewDirectionZ{};
+
+	// clip planes the vertex lies outside of, against the frustum and against the guard band
+	uint8_t* pFrustumOutCodes{};
+	uint8_t* pGuardBandOutCodes{};
+
+private:
+	void* m_pData{};
+};
+
+// an attribute as a plane over raster space, relative to the raster position of the first vertex
+template<typename T>
+struct AttributePlane
+{
+	T value0;
+	T ddx;
+	T ddy;
+
+	T Evaluate(float dx, float dy) const { return value0 + ddx * dx + ddy * dy; }
+
+	static AttributePlane Create(const T& value0, const T& value1, const T& value2,
+		float dx1, float dy1, float dx2, float dy2, float invArea)
+	{
+		const T delta1 = value1 - value0;
+		const T delta2 = value2 - value0;
+		return { value0, (delta1 * dy2 - delta2 * dy1) * invArea, (delta2 * dx1 - delta1 * dx2) * invArea };
+	}
+};
+
+// attributes divided by w at a single pixel
+struct PixelInterpolants
+{
+	float invW;
+	Vector2 uvOverW;
+	Vector3 normalOverW;
+	Vector3 tangentOverW;
+	Vector3 viewDirectionOverW;
+};
+
+struct TriangleOut
+{
+	// vertices in raster space
+	VertexOut v0;
+	VertexOut v1;
+	VertexOut v2;
+
+	// everything divided by w is linear in raster space, so it is set up once per triangle
+	AttributePlane<float> depth;
+	AttributePlane<float> invW;
+	AttributePlane<Vector2> uvOverW;
+	AttributePlane<Vector3> normalOverW;
+	AttributePlane<Vector3> tangentOverW;
+	AttributePlane<Vector3> viewDirectionOverW;
+
+	// smallest depth any pixel of the triangle can have
+	float nearestDepth;
+
+	// coverage of the 4x4 pixels at (minX, minY), row by row, only set for triangles that fit in there
+	uint32_t stampCoverage;
+
+	// bounding box of the pixels whose center the triangle can cover, inclusive
+	int minX;
+	int minY;
+	int maxX;
+	int maxY;
+
+	PixelInterpolants EvaluateInterpolants(float dx, float dy) const
+	{
+		return { invW.Evaluate(dx, dy), uvOverW.Evaluate(dx, dy), normalOverW.Evaluate(dx, dy),
+			tangentOverW.Evaluate(dx, dy), viewDirectionOverW.Evaluate(dx, dy) };
+	}
+
+	// the point itself when the triangle contains it, otherwise the point of the triangle its barycentric coordinates clamp to
+	Vector2 ClampInside(float x, float y) const
+	{
+		const auto getEdgeValue = [x, y](const Vector4& from, const Vector4& to)
+			{
+				return (to.x - from.x) * (y - from.y) - (to.y - from.y) * (x - from.x);
+			};
+		const float weight0 = getEdgeValue(v1.position, v2.position);
+		const float weight1 = getEdgeValue(v2.position, v0.position);
+		const float weight2 = getEdgeValue(v0.position, v1.position);
+
+		if (weight0 >= 0 && weight1 >= 0 && weight2 >= 0)
+			return { x, y };
+
+		// the weights add up to twice the area, which is never zero, so at least one of them is positive
+		const float clampedWeight0 = std::max(weight0, 0.f);
+		const float clampedWeight1 = std::max(weight1, 0.f);
+		const float clampedWeight2 = std::max(weight2, 0.f);
+		const float invWeightSum = 1.f / (clampedWeight0 + clampedWeight1 + clampedWeight2);
+
+		return {
+			(clampedWeight0 * v0.position.x + clampedWeight1 * v1.position.x + clampedWeight2 * v2.position.x) * invWeightSum,
+			(clampedWeight0 * v0.position.y + clampedWeight1 * v1.position.y + clampedWeight2 * v2.position.y) * invWeightSum };
+	}
+
+	// moves the interpolants one pixel to the right
+	void StepInterpolantsX(PixelInterpolants& interpolants) const
+	{
+		interpolants.invW += invW.ddx;
+		interpolants.uvOverW += uvOverW.ddx;
+		interpolants.normalOverW += normalOverW.ddx;
+		interpolants.tangentOverW += tangentOverW.ddx;
+		interpolants.viewDirectionOverW += viewDirectionOverW.ddx;
+	}
 };
 
 class Mesh final
@@ -45,9 +218,19 @@ public:
 	Matrix GetWorldMatrix() const { return m_WorldMatrix; }
 
 	std::vector<Vertex> vertices;
-	std::vector<VertexOut> verticesOut;
+	VertexOutBuffer verticesOut;
+	std::vector<TriangleOut> trianglesOut;
+	// triangles of the next frame, assembled while trianglesOut is rasterized in the pipelined mode
+	std::vector<TriangleOut> pendingTrianglesOut;
 	std::vector<uint32_t> indices;
 
+	// axis aligned box around the vertices in object space, the software occlusion culling tests it before the vertices are transformed
+	Vector3 boundsMin;
+	Vector3 boundsMax;
+
+	// drawn into the occluder depth before the other meshes are tested against it, so it is never culled itself
+	bool isOccluder{ false };
+
 private:
 	ID3D11Buffer* m_pVertexBuffer{};
 	Effect* m_pEffect;
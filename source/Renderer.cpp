@@ -3,10 +3,10 @@
 
 #include <ranges>
 
-#include "BRDF.h"
 #include "Camera.h"
 #include "TransEffect.h"
 #include "ShadedEffect.h"
+#include "SoftwareRenderer.h"
 #include "Utils.h"
 
 namespace dae {
@@ -17,12 +17,14 @@ namespace dae {
 		//Initialize
 		SDL_GetWindowSize(pWindow, &m_Width, &m_Height);
 
-		//Create Buffers
-		m_pFrontBuffer = SDL_GetWindowSurface(pWindow);
-		m_pBackBuffer = SDL_CreateRGBSurface(0, m_Width, m_Height, 32, 0, 0, 0, 0);
-		m_pBackBufferPixels = (uint32_t*)m_pBackBuffer->pixels;
+		m_pMeshToShadedEffectMap = new std::map<Mesh*, ShadedEffect*>;
+		m_pMeshToTransEffectMap = new std::map<Mesh*, TransEffect*>;
+
+		m_pCamera = new Camera();
+		m_pCamera->Initialize(45.f, Vector3{ 0.f,0.f,0.f }, m_Width / (float)m_Height);
 
-		m_pDepthBufferPixels = new float[(int)(m_Width * m_Height)];
+		//Create Buffers
+		m_pSoftwareRenderer = new SoftwareRenderer{ pWindow, m_pCamera, m_pMeshToShadedEffectMap };
 
 		//Initialize DirectX pipeline
 		const HRESULT result = InitializeDirectX();
@@ -36,9 +38,6 @@ namespace dae {
 			std::cout << "DirectX initialization failed!\n";
 		}
 
-		m_pMeshToShadedEffectMap = new std::map<Mesh*, ShadedEffect*>;
-		m_pMeshToTransEffectMap = new std::map<Mesh*, TransEffect*>;
-
 		VehicleMeshInit();
 
 		if (m_UseHardware)
@@ -46,15 +45,13 @@ namespace dae {
 			CombustionMeshInit();
 		}
 
-		m_pCamera = new Camera();
-		m_pCamera->Initialize(45.f, Vector3{ 0.f,0.f,0.f }, m_Width / (float)m_Height);
-
 		m_BackGroundColor = ColorRGB{ 99 / 255.f,150 / 255.f,237 / 255.f };
+		m_pSoftwareRenderer->SetBackGroundColor(m_BackGroundColor);
 	}
 
 	Renderer::~Renderer()
 	{
-		delete[] m_pDepthBufferPixels;
+		delete m_pSoftwareRenderer;
 
 		delete m_pVehicleDiffuse;
 		delete m_pVehicleNormalMap;
@@ -69,6 +66,12 @@ namespace dae {
 		}
 		delete m_pMeshToShadedEffectMap;
 
+		if (m_ShowHiddenVehicle == false)
+		{
+			delete m_pHiddenVehicleEffect;
+			delete m_pHiddenVehicle;
+		}
+
 		for (const auto& [mesh, shadedEffect] : *m_pMeshToTransEffectMap)
 		{
 			delete shadedEffect;
@@ -120,6 +123,9 @@ namespace dae {
 	{
 		m_pCamera->Update(pTimer);
 
+		if (m_UseHardware == false)
+			m_pSoftwareRenderer->Update(pTimer->GetElapsed());
+
 		const auto viewMatrix = m_pCamera->GetViewMatrix();
 		const auto projectionMatrix = m_pCamera->GetProjectionMatrix();
 		const auto invViewMatrix = m_pCamera->GetInvViewMatrix();
@@ -183,24 +189,7 @@ namespace dae {
 		}
 		else
 		{
-			SDL_LockSurface(m_pBackBuffer);
-
-			std::fill_n(m_pDepthBufferPixels, m_Width * m_Height, FLT_MAX);
-
-			ClearBackground();
-
-			for (const auto& mesh : *m_pMeshToShadedEffectMap | std::views::keys)
-			{
-				VertexTransformationFunction(*mesh);
-
-				RenderTriangleList(*mesh);
-			}
-
-			//@END
-			//Update SDL Surface
-			SDL_UnlockSurface(m_pBackBuffer);
-			SDL_BlitSurface(m_pBackBuffer, 0, m_pFrontBuffer, 0);
-			SDL_UpdateWindowSurface(m_pWindow);
+			m_pSoftwareRenderer->Render();
 		}
 	}
 
@@ -216,6 +205,10 @@ namespace dae {
 			SetConsoleTextAttribute(h, 7);
 
 			m_BackGroundColor = ColorRGB{ 100 / 255.f,100 / 255.f ,100 / 255.f };
+			m_pSoftwareRenderer->SetBackGroundColor(m_BackGroundColor);
+
+			// the triangles are from the last software frame
+			m_pSoftwareRenderer->InvalidateTriangles();
 		}
 		else if (m_UseHardware == false)
 		{
@@ -225,6 +218,13 @@ namespace dae {
 			SetConsoleTextAttribute(h, 7);
 
 			m_BackGroundColor = ColorRGB{ 99 / 255.f,150 / 255.f,237 / 255.f };
+
+			// the hidden vehicle is not part of the hardware scene
+			if (m_ShowHiddenVehicle)
+			{
+				m_pMeshToShadedEffectMap->erase(m_pHiddenVehicle);
+				m_ShowHiddenVehicle = false;
+			}
 		}
 	}
 	void Renderer::ToggleRotation()
@@ -308,6 +308,7 @@ namespace dae {
 			effect->SetRasterizerState(m_pRasterizerState);
 		}
 
+		m_pSoftwareRenderer->CycleCullMode();
 	}
 	void Renderer::ToggleUniformClearColor()
 	{
@@ -335,6 +336,8 @@ namespace dae {
 			std::cout << "**(SHARED) Uniform ClearColor ON\n";
 			SetConsoleTextAttribute(h, 7);
 		}
+
+		m_pSoftwareRenderer->SetBackGroundColor(m_BackGroundColor);
 	}
 
 	//SOFTWARE
@@ -342,106 +345,130 @@ namespace dae {
 	{
 		if (m_UseHardware) return;
 
-		HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
-		switch (m_CurrentShadingMode)
-		{
-		case ShadingMode::observedArea:
-			SetConsoleTextAttribute(h, 5);
-			std::cout << "**(SOFTWARE) Shading Mode = DIFFUSE\n";
-			SetConsoleTextAttribute(h, 7);
+		m_pSoftwareRenderer->CycleShadingMode();
+	}
+	void Renderer::ToggleNormalMap()
+	{
+		if (m_UseHardware) return;
 
-			m_CurrentShadingMode = ShadingMode::diffuse;
-			break;
-		case ShadingMode::diffuse:
-			SetConsoleTextAttribute(h, 5);
-			std::cout << "**(SOFTWARE) Shading Mode = SPECULAR\n";
-			SetConsoleTextAttribute(h, 7);
+		m_pSoftwareRenderer->ToggleNormalMap();
+	}
+	void Renderer::ToggleDepthBufferVisualization()
+	{
+		if (m_UseHardware) return;
 
-			m_CurrentShadingMode = ShadingMode::specular;
+		m_pSoftwareRenderer->ToggleDepthBufferVisualization();
+	}
+	void Renderer::ToggleBoundingBoxVisualization()
+	{
+		if (m_UseHardware) return;
 
-			break;
-		case ShadingMode::specular:
-			SetConsoleTextAttribute(h, 5);
-			std::cout << "**(SOFTWARE) Shading Mode = COMBINED\n";
-			SetConsoleTextAttribute(h, 7);
+		m_pSoftwareRenderer->ToggleBoundingBoxVisualization();
+	}
+	void Renderer::ToggleTileBinning()
+	{
+		if (m_UseHardware) return;
 
-			m_CurrentShadingMode = ShadingMode::combined;
+		m_pSoftwareRenderer->ToggleTileBinning();
+	}
+	void Renderer::ToggleHierarchicalDepth()
+	{
+		if (m_UseHardware) return;
 
-			break;
-		case ShadingMode::combined:
-			SetConsoleTextAttribute(h, 5);
-			std::cout << "**(SOFTWARE) Shading Mode = OBSERVED AREA\n";
-			SetConsoleTextAttribute(h, 7);
+		m_pSoftwareRenderer->ToggleHierarchicalDepth();
+	}
+	void Renderer::CycleRenderPath()
+	{
+		if (m_UseHardware) return;
 
-			m_CurrentShadingMode = ShadingMode::observedArea;
-			break;
-		}
+		m_pSoftwareRenderer->CycleRenderPath();
 	}
-	void Renderer::ToggleNormalMap()
+	void Renderer::CycleRasterTraversal()
 	{
 		if (m_UseHardware) return;
 
-		HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
-		if (m_EnableNormalMap == true)
-		{
-			SetConsoleTextAttribute(h, 5);
-			std::cout << "**(SOFTWARE) NormalMap OFF\n";
-			SetConsoleTextAttribute(h, 7);
+		m_pSoftwareRenderer->CycleRasterTraversal();
+	}
+	void Renderer::TogglePipelinedFrames()
+	{
+		if (m_UseHardware) return;
 
-			m_EnableNormalMap = false;
-		}
-		else if (m_EnableNormalMap == false)
-		{
-			SetConsoleTextAttribute(h, 5);
-			std::cout << "**(SOFTWARE) NormalMap ON\n";
-			SetConsoleTextAttribute(h, 7);
+		m_pSoftwareRenderer->TogglePipelinedFrames();
+	}
+	void Renderer::ToggleHdrColorBuffer()
+	{
+		if (m_UseHardware) return;
 
-			m_EnableNormalMap = true;
-		}
+		m_pSoftwareRenderer->ToggleHdrColorBuffer();
 	}
-	void Renderer::ToggleDepthBufferVisualization()
+	void Renderer::CycleToneMapping()
 	{
 		if (m_UseHardware) return;
 
-		HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
-		if (m_DepthBufferVisualization == true)
-		{
-			SetConsoleTextAttribute(h, 5);
-			std::cout << "**(SOFTWARE) DepthBuffer Visualization OFF\n";
-			SetConsoleTextAttribute(h, 7);
+		m_pSoftwareRenderer->CycleToneMapping();
+	}
+	void Renderer::CycleDepthFormat()
+	{
+		if (m_UseHardware) return;
 
-			m_DepthBufferVisualization = false;
-		}
-		else if (m_DepthBufferVisualization == false)
-		{
-			SetConsoleTextAttribute(h, 5);
-			std::cout << "**(SOFTWARE) DepthBuffer Visualization ON\n";
-			SetConsoleTextAttribute(h, 7);
+		m_pSoftwareRenderer->CycleDepthFormat();
+	}
+	void Renderer::ToggleTiledFrameBuffer()
+	{
+		if (m_UseHardware) return;
 
-			m_DepthBufferVisualization = true;
-		}
+		m_pSoftwareRenderer->ToggleTiledFrameBuffer();
 	}
-	void Renderer::ToggleBoundingBoxVisualization()
+	void Renderer::ToggleMultisampling()
+	{
+		if (m_UseHardware) return;
+
+		m_pSoftwareRenderer->ToggleMultisampling();
+	}
+	void Renderer::ToggleDynamicResolution()
+	{
+		if (m_UseHardware) return;
+
+		m_pSoftwareRenderer->ToggleDynamicResolution();
+	}
+	void Renderer::CycleShadingRate()
+	{
+		if (m_UseHardware) return;
+
+		m_pSoftwareRenderer->CycleShadingRate();
+	}
+	void Renderer::ToggleOcclusionCulling()
+	{
+		if (m_UseHardware) return;
+
+		m_pSoftwareRenderer->ToggleOcclusionCulling();
+	}
+	void Renderer::ToggleHiddenVehicle()
 	{
 		if (m_UseHardware) return;
 
 		HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
-		if (m_BoundingBoxVisualization == true)
+		if (m_ShowHiddenVehicle == true)
 		{
 			SetConsoleTextAttribute(h, 5);
-			std::cout << "**(SOFTWARE) DepthBuffer Visualization OFF\n";
+			std::cout << "**(SOFTWARE) Hidden Vehicle OFF\n";
 			SetConsoleTextAttribute(h, 7);
 
-			m_BoundingBoxVisualization = false;
+			m_pMeshToShadedEffectMap->erase(m_pHiddenVehicle);
+			m_ShowHiddenVehicle = false;
 		}
-		else if (m_BoundingBoxVisualization == false)
+		else if (m_ShowHiddenVehicle == false)
 		{
 			SetConsoleTextAttribute(h, 5);
-			std::cout << "**(SOFTWARE) DepthBuffer Visualization ON\n";
+			std::cout << "**(SOFTWARE) Hidden Vehicle ON\n";
 			SetConsoleTextAttribute(h, 7);
 
-			m_BoundingBoxVisualization = true;
+			m_pMeshToShadedEffectMap->insert(std::make_pair(m_pHiddenVehicle, m_pHiddenVehicleEffect));
+			m_ShowHiddenVehicle = true;
 		}
+
+		// the pipelined frame was assembled without it
+		m_pSoftwareRenderer->InvalidateTriangles();
 	}
 
 	//HARDWARE
@@ -544,6 +571,7 @@ namespace dae {
 		m_pVehicleNormalMap = Texture::LoadFromFile("resources/vehicle_normal.png", m_pDevice);
 		m_pVehicleSpecularMap = Texture::LoadFromFile("resources/vehicle_specular.png", m_pDevice);
 		m_pVehicleGlossinessMap = Texture::LoadFromFile("resources/vehicle_gloss.png", m_pDevice);
+		m_pSoftwareRenderer->SetVehicleTextures(m_pVehicleDiffuse, m_pVehicleNormalMap, m_pVehicleGlossinessMap, m_pVehicleSpecularMap);
 
 		const Vector3 position{ 0,0,50 };
 		const Vector3 rotation{ 0,0,0 };
@@ -560,10 +588,25 @@ namespace dae {
 
 		auto pMesh = new Mesh{ m_pDevice, vertices, indices, pShadedEffect };
 		pMesh->SetWorldMatrix(worldMatrix);
+		pMesh->isOccluder = true;
 
 		std::pair<Mesh*, ShadedEffect*> pair(pMesh, pShadedEffect);
 
 		m_pMeshToShadedEffectMap->insert(pair);
+
+		// the hidden vehicle only gets into the mesh map when it is toggled on
+		const Matrix hiddenWorldMatrix = Matrix::CreateScale(Vector3{ 0.5f,0.5f,0.5f }) * Matrix::CreateRotation(rotation) * Matrix::CreateTranslation(Vector3{ 0,0,120 });
+
+		m_pHiddenVehicleEffect = new ShadedEffect{ m_pDevice, L"resources/Vehicle.fx" };
+		m_pHiddenVehicleEffect->SetDiffuseMap(m_pVehicleDiffuse);
+		m_pHiddenVehicleEffect->SetNormalMap(m_pVehicleNormalMap);
+		m_pHiddenVehicleEffect->SetSpecularMap(m_pVehicleSpecularMap);
+		m_pHiddenVehicleEffect->SetGlossinessMap(m_pVehicleGlossinessMap);
+
+		m_pHiddenVehicleEffect->SetWorldMatrixVariable(hiddenWorldMatrix);
+
+		m_pHiddenVehicle = new Mesh{ m_pDevice, vertices, indices, m_pHiddenVehicleEffect };
+		m_pHiddenVehicle->SetWorldMatrix(hiddenWorldMatrix);
 	}
 	void Renderer::CombustionMeshInit()
 	{
@@ -589,317 +632,6 @@ namespace dae {
 		m_pMeshToTransEffectMap->insert(std::make_pair(pMesh, pTransEffect));
 	}
 #pragma endregion
-#pragma region SoftwareHelpers
-	void Renderer::VertexTransformationFunction(Mesh& m) const
-	{
-		m.verticesOut.clear();
-		m.verticesOut.reserve(m.vertices.size());
-
-		const Matrix worldViewProjectionMatrix = m.GetWorldMatrix() * m_pCamera->GetViewMatrix() * m_pCamera->GetProjectionMatrix();
-
-		for (const auto& v : m.vertices)
-		{
-			VertexOut vertexOut{};
-
-			// to NDC-Space
-			vertexOut.position = worldViewProjectionMatrix.TransformPoint(v.position.ToVector4());
-
-			vertexOut.viewDirection = Vector3{ vertexOut.position.GetXYZ() };
-			vertexOut.viewDirection.Normalize();
-
-			vertexOut.position.x /= vertexOut.position.w;
-			vertexOut.position.y /= vertexOut.position.w;
-			vertexOut.position.z /= vertexOut.position.w;
-
-			vertexOut.color = v.color;
-			vertexOut.normal = m.GetWorldMatrix().TransformVector(v.normal).Normalized();
-			vertexOut.uv = v.uv;
-			vertexOut.tangent = m.GetWorldMatrix().TransformVector(v.tangent).Normalized();
-
-			m.verticesOut.emplace_back(vertexOut);
-		}
-	}
-	void Renderer::RenderTriangleList(Mesh& mesh) const
-	{
-		ColorRGB finalColor{ };
-
-		for (size_t i{}; i < mesh.indices.size(); i += 3)
-		{
-			VertexOut vOut0 = mesh.verticesOut[mesh.indices[i]];
-			VertexOut vOut1 = mesh.verticesOut[mesh.indices[i + 1]];
-			VertexOut vOut2 = mesh.verticesOut[mesh.indices[i + 2]];
-
-			// frustum culling check
-			if (!IsInFrustum(vOut0)
-				|| !IsInFrustum(vOut1)
-				|| !IsInFrustum(vOut2))
-				continue;
-
-			// from NDC space to Raster space
-			NDCToRaster(vOut0);
-			NDCToRaster(vOut1);
-			NDCToRaster(vOut2);
-
-			const Vector2 v0 = { vOut0.position.x, vOut0.position.y };
-			const Vector2 v1 = { vOut1.position.x, vOut1.position.y };
-			const Vector2 v2 = { vOut2.position.x, vOut2.position.y };
-
-			const Vector2 edge01 = v1 - v0;
-			const Vector2 edge12 = v2 - v1;
-			const Vector2 edge20 = v0 - v2;
-
-			const float areaTriangle = Vector2::Cross(edge01, edge12);
-
-			// create bounding box for triangle
-			const INT top = std::max((INT)std::max(v0.y, v1.y), (INT)v2.y);
-			const INT bottom = std::min((INT)std::min(v0.y, v1.y), (INT)v2.y);
-
-			const INT left = std::min((INT)std::min(v0.x, v1.x), (INT)v2.x);
-			const INT right = std::max((INT)std::max(v0.x, v1.x), (INT)v2.x);
-
-			// check if bounding box is in screen
-			if (left <= 0 || right >= m_Width - 1)
-				continue;
-
-			if (bottom <= 0 || top >= m_Height - 1)
-				continue;
-
-			constexpr INT offSet{ 1 };
-
-			// iterate over every pixel in the bounding box, with an offset we enlarge the BB
-			// in case of overlooked pixels
-			for (INT px = left - offSet; px < right + offSet; ++px)
-			{
-				for (INT py = bottom - offSet; py < top + offSet; ++py)
-				{
-					if (m_BoundingBoxVisualization == false)
-					{
-						finalColor = colors::Black;
-
-						Vector2 pixelPos = { (float)px,(float)py };
-
-						const Vector2 directionV0 = pixelPos - v0;
-						const Vector2 directionV1 = pixelPos - v1;
-						const Vector2 directionV2 = pixelPos - v2;
-
-						// weights are all negative => back-face culling
-						// vs all positive => front-face culling
-						float weightV2 = Vector2::Cross(edge01, directionV0);
-						if (weightV2 < 0 && 
-							(m_CurrentCullMode == CullMode::back || m_CurrentCullMode == CullMode::none))
-							continue;
-						if (weightV2 > 0 && m_CurrentCullMode == CullMode::front)
-							continue;
-
-						float weightV0 = Vector2::Cross(edge12, directionV1);
-						if (weightV0 < 0 && 
-							(m_CurrentCullMode == CullMode::back || m_CurrentCullMode == CullMode::none))
-
-							continue;
-						if (weightV0 > 0 && m_CurrentCullMode == CullMode::front)
-							continue;
-
-						float weightV1 = Vector2::Cross(edge20, directionV2);
-						if (weightV1 < 0 && 
-							(m_CurrentCullMode == CullMode::back || m_CurrentCullMode == CullMode::none))
-							continue;
-						if (weightV1 > 0 && m_CurrentCullMode == CullMode::front)
-							continue;
-
-						weightV0 /= areaTriangle;
-						weightV1 /= areaTriangle;
-						weightV2 /= areaTriangle;
-
-						if (weightV0 + weightV1 + weightV2 < 1 - FLT_EPSILON
-							&& weightV0 + weightV1 + weightV2 > 1 + FLT_EPSILON)
-							continue;
-
-						// This Z-BufferValue is the one we compare in the Depth Test and
-						// the value we store in the Depth Buffer (uses position.z).
-						float interpolatedZDepth = {
-							1.f /
-							((1 / vOut0.position.z) * weightV0 +
-							(1 / vOut1.position.z) * weightV1 +
-							(1 / vOut2.position.z) * weightV2)
-						};
-
-						if (interpolatedZDepth < 0 || interpolatedZDepth > 1)
-							continue;
-
-						if (interpolatedZDepth > m_pDepthBufferPixels[px + (py * m_Width)])
-							continue;
-
-						m_pDepthBufferPixels[px + (py * m_Width)] = interpolatedZDepth;
-
-						if (m_DepthBufferVisualization == false)
-						{
-							// When we want to interpolate vertex attributes with a correct depth(color, uv, normals, etc.),
-							// we still use the View Space depth(uses position.w)
-							const float interpolatedWDepth = {
-								1.f /
-								((1 / vOut0.position.w) * weightV0 +
-								(1 / vOut1.position.w) * weightV1 +
-								(1 / vOut2.position.w) * weightV2)
-							};
-
-							const Vector2 interpolatedUV = {
-								((vOut0.uv / vOut0.position.w) * weightV0 +
-								(vOut1.uv / vOut1.position.w) * weightV1 +
-								(vOut2.uv / vOut2.position.w) * weightV2) * interpolatedWDepth
-							};
-
-							const Vector3 interpolatedNormal = {
-								((vOut0.normal / vOut0.position.w) * weightV0 +
-								(vOut1.normal / vOut1.position.w) * weightV1 +
-								(vOut2.normal / vOut2.position.w) * weightV2) * interpolatedWDepth
-							};
-
-							const Vector3 interpolatedTangent = {
-								((vOut0.tangent / vOut0.position.w) * weightV0 +
-								(vOut1.tangent / vOut1.position.w) * weightV1 +
-								(vOut2.tangent / vOut2.position.w) * weightV2) * interpolatedWDepth
-							};
-
-							const Vector3 interpolatedViewDirection = {
-								((vOut0.viewDirection / vOut0.position.w) * weightV0 +
-								(vOut1.viewDirection / vOut1.position.w) * weightV1 +
-								(vOut2.viewDirection / vOut2.position.w) * weightV2) * interpolatedWDepth
-							};
-
-							//Interpolated Vertex Attributes for Pixel
-							VertexOut pixel;
-							pixel.position = { pixelPos.x, pixelPos.y, interpolatedZDepth, interpolatedWDepth };
-							pixel.color = finalColor;
-							pixel.uv = interpolatedUV;
-							pixel.normal = interpolatedNormal;
-							pixel.tangent = interpolatedTangent;
-							pixel.viewDirection = interpolatedViewDirection;
-
-							PixelShading(pixel);
-
-							finalColor = pixel.color;
-						}
-						else
-						{
-							const float depthBufferColor = Remap(m_pDepthBufferPixels[px + (py * m_Width)], 0.995f, 1.0f);
-
-							finalColor = { depthBufferColor, depthBufferColor, depthBufferColor };
-						}
-					}
-					else
-					{
-						finalColor = colors::White;
-					}
-
-					//Update Color in Buffer
-					finalColor.MaxToOne();
-
-					m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-						static_cast<uint8_t>(finalColor.r * 255),
-						static_cast<uint8_t>(finalColor.g * 255),
-						static_cast<uint8_t>(finalColor.b * 255));
-				}
-			}
-		}
-	}
-	void Renderer::PixelShading(VertexOut& v) const
-	{
-		ColorRGB tempColor{ colors::Black };
-
-		const Vector3 directionToLight = -Vector3{ .577f,-.577f,.577f };
-		constexpr float lightIntensity = 7.f;
-		constexpr float specularShininess = 25.f;
-
-		Vector3 normal;
-
-		if (m_EnableNormalMap)
-		{
-			// Normal map
-			const Vector3 biNormal = Vector3::Cross(v.normal, v.tangent);
-			const Matrix tangentSpaceAxis = { v.tangent, biNormal, v.normal, Vector3::Zero };
-
-			const ColorRGB normalColor = m_pVehicleNormalMap->Sample(v.uv);
-			Vector3 sampledNormal = { normalColor.r, normalColor.g, normalColor.b }; // => range [0, 1]
-			sampledNormal = 2.f * sampledNormal - Vector3{ 1, 1, 1 }; // => [0, 1] to [-1, 1]
-
-			sampledNormal = tangentSpaceAxis.TransformVector(sampledNormal);
-
-			normal = sampledNormal.Normalized();
-			////////////////////
-		}
-		else
-			normal = v.normal;
-
-		// Observed Area
-		const float lambertCos = Vector3::Dot(normal, directionToLight);
-		if (lambertCos < 0)
-			return;
-
-		const ColorRGB observedArea = { lambertCos, lambertCos, lambertCos };
-		////////////////////
-
-		ColorRGB diffuse;
-
-		// phong specular
-		const ColorRGB gloss = m_pVehicleGlossinessMap->Sample(v.uv);
-		const float exponent = gloss.r * specularShininess;
-
-		ColorRGB specular;
-		////////////////////////
-
-		switch (m_CurrentShadingMode)
-		{
-		case ShadingMode::observedArea:
-			tempColor += observedArea;
-			break;
-		case ShadingMode::diffuse:
-			diffuse = BRDF::Lambert(m_pVehicleDiffuse->Sample(v.uv));
-
-			tempColor += diffuse * observedArea * lightIntensity;
-			break;
-		case ShadingMode::specular:
-			specular = BRDF::Phong(m_pVehicleSpecularMap->Sample(v.uv), exponent, directionToLight, v.viewDirection, normal);
-
-			tempColor += specular * observedArea;
-			break;
-		case ShadingMode::combined:
-			specular = BRDF::Phong(m_pVehicleSpecularMap->Sample(v.uv), exponent, directionToLight, v.viewDirection, normal);
-			diffuse = BRDF::Lambert(m_pVehicleDiffuse->Sample(v.uv));
-
-			tempColor += diffuse * observedArea * lightIntensity + specular;
-			break;
-		}
-
-		constexpr ColorRGB ambient = { .025f,.025f,.025f };
-
-		tempColor += ambient;
-
-		v.color = tempColor;
-
-	}
-	bool Renderer::IsInFrustum(const VertexOut& v) const
-	{
-		if (v.position.x < -1 || v.position.x > 1)
-			return false;
-
-		if (v.position.y < -1 || v.position.y > 1)
-			return  false;
-
-		if (v.position.z < 0 || v.position.z > 1)
-			return  false;
-
-		return true;
-	}
-	void Renderer::NDCToRaster(VertexOut& v) const
-	{
-		v.position.x = (v.position.x + 1) * 0.5f * (float)m_Width;
-		v.position.y = (1 - v.position.y) * 0.5f * (float)m_Height;
-	}
-	void Renderer::ClearBackground() const
-	{
-		SDL_FillRect(m_pBackBuffer, nullptr, SDL_MapRGB(m_pBackBuffer->format, (Uint8)(m_BackGroundColor.r * 255.f), (Uint8)(m_BackGroundColor.g * 255.f), (Uint8)(m_BackGroundColor.b * 255.f)));
-	}
-#pragma endregion
 #pragma region HardwareHelpers
 	HRESULT Renderer::InitializeDirectX()
 	{
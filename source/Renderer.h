@@ -15,6 +15,7 @@ class HardwareRenderer;
 namespace dae
 {
 	class Texture;
+	class SoftwareRenderer;
 
 	class Renderer
 	{
@@ -40,6 +41,20 @@ namespace dae
 		void ToggleNormalMap();
 		void ToggleDepthBufferVisualization();
 		void ToggleBoundingBoxVisualization();
+		void ToggleTileBinning();
+		void ToggleHierarchicalDepth();
+		void CycleRenderPath();
+		void CycleRasterTraversal();
+		void TogglePipelinedFrames();
+		void ToggleHdrColorBuffer();
+		void CycleToneMapping();
+		void CycleDepthFormat();
+		void ToggleTiledFrameBuffer();
+		void ToggleMultisampling();
+		void ToggleDynamicResolution();
+		void CycleShadingRate();
+		void ToggleOcclusionCulling();
+		void ToggleHiddenVehicle();
 
 	private:
 		enum class SamplerState
@@ -54,22 +69,9 @@ namespace dae
 			front,
 			none
 		};
-		enum class ShadingMode
-		{
-			observedArea,
-			diffuse,
-			specular,
-			combined
-		};
 
 		SDL_Window* m_pWindow{};
 
-		SDL_Surface* m_pFrontBuffer{ nullptr };
-		SDL_Surface* m_pBackBuffer{ nullptr };
-		uint32_t* m_pBackBufferPixels{};
-
-		float* m_pDepthBufferPixels{};
-
 		int m_Width{};
 		int m_Height{};
 
@@ -84,11 +86,7 @@ namespace dae
 		bool m_UseUniformClearColor{ true };
 		ColorRGB m_BackGroundColor;
 
-		ShadingMode m_CurrentShadingMode{ ShadingMode::combined };
-
-		bool m_EnableNormalMap{ true };
-		bool m_DepthBufferVisualization{ false };
-		bool m_BoundingBoxVisualization{ false };
+		bool m_ShowHiddenVehicle{ false };
 
 		SamplerState m_CurrentSamplerState{ SamplerState::point };
 
@@ -105,20 +103,17 @@ namespace dae
 		Texture* m_pVehicleGlossinessMap;
 		Texture* m_pVehicleSpecularMap;
 
+		// software only, in the mesh map while it is shown
+		Mesh* m_pHiddenVehicle{};
+		ShadedEffect* m_pHiddenVehicleEffect{};
+
 		Texture* m_pFireFXDiffuse;
 
 		void VehicleMeshInit();
 		void CombustionMeshInit();
 
 		//SOFTWARE
-		void RenderTriangleList(Mesh& mesh) const;
-		void VertexTransformationFunction(Mesh& meshes) const;
-		void PixelShading(VertexOut& v) const;
-
-		bool IsInFrustum(const VertexOut& v) const;
-		void NDCToRaster(VertexOut& v) const;
-
-		void ClearBackground() const;
+		SoftwareRenderer* m_pSoftwareRenderer{};
 
 		//DIRECTX - HARDWARE
 		HRESULT InitializeDirectX();
@@ -1,2 +1,3002 @@
 #include "pch.h"
 #include "SoftwareRenderer.h"
+
+#include <bit>
+#include <immintrin.h>
+#include <ranges>
+
+#include "BRDF.h"
+#include "Camera.h"
+#include "Texture.h"
+#include "ThreadPool.h"
+
+namespace dae {
+
+	SoftwareRenderer::SoftwareRenderer(SDL_Window* pWindow, const Camera* pCamera, std::map<Mesh*, ShadedEffect*>* pMeshToShadedEffectMap) :
+		m_pWindow(pWindow),
+		m_pCamera(pCamera),
+		m_pMeshToShadedEffectMap(pMeshToShadedEffectMap)
+	{
+		//Initialize
+		SDL_GetWindowSize(pWindow, &m_WindowWidth, &m_WindowHeight);
+
+		//Create Buffers
+		m_pFrontBuffer = SDL_GetWindowSurface(pWindow);
+
+		// allocated for the window, a lower render resolution uses the start of it
+		const int maxNrOfDepthBlocks = ((m_WindowWidth + DEPTH_BLOCK_SIZE - 1) / DEPTH_BLOCK_SIZE) * ((m_WindowHeight + DEPTH_BLOCK_SIZE - 1) / DEPTH_BLOCK_SIZE);
+		m_pCoarseDepthBufferPixels = new float[maxNrOfDepthBlocks];
+		m_pOccluderDepthBuffer = new float[maxNrOfDepthBlocks];
+		m_pOccluderCoverage = new uint64_t[maxNrOfDepthBlocks];
+		m_pOccluderCoverageDepths = new float[maxNrOfDepthBlocks];
+		m_pDepthBlockStates = new DepthBlockState[maxNrOfDepthBlocks];
+		m_pDepthBlockPlanes = new const TriangleOut*[maxNrOfDepthBlocks];
+
+		// big enough for both layouts
+		const int maxNrOfBufferPixels = maxNrOfDepthBlocks * DEPTH_BLOCK_SIZE * DEPTH_BLOCK_SIZE;
+
+		m_pTiledBackBufferPixels = new uint32_t[maxNrOfBufferPixels];
+		m_pColorBufferPixels = new ColorRGB[maxNrOfBufferPixels];
+		m_pDepthBuffer = new uint8_t[maxNrOfBufferPixels * MSAA_SAMPLE_COUNT * sizeof(float)];
+
+		m_pVisibilityBuffer = new uint32_t[maxNrOfBufferPixels * MSAA_SAMPLE_COUNT];
+
+		m_pShadingCellTriangles = new uint32_t[maxNrOfDepthBlocks * SHADING_CELLS_PER_BLOCK];
+		m_pShadingCellColors = new ColorRGB[maxNrOfDepthBlocks * SHADING_CELLS_PER_BLOCK];
+
+		m_pSamplePixels = new uint32_t[maxNrOfBufferPixels * MSAA_SAMPLE_COUNT];
+		m_pSampleColorBufferPixels = new ColorRGB[maxNrOfBufferPixels * MSAA_SAMPLE_COUNT];
+
+		//Create Tiles
+		m_pTiles = new Tile[((m_WindowWidth + TILE_SIZE - 1) / TILE_SIZE) * ((m_WindowHeight + TILE_SIZE - 1) / TILE_SIZE)];
+
+		SetRenderResolution(m_WindowWidth, m_WindowHeight);
+
+		// 32 bits per pixel, only the position of the channels differs
+		m_RedShift = m_pBackBuffer->format->Rshift;
+		m_GreenShift = m_pBackBuffer->format->Gshift;
+		m_BlueShift = m_pBackBuffer->format->Bshift;
+		m_AlphaMask = m_pBackBuffer->format->Amask;
+
+		m_pThreadPool = new ThreadPool();
+		m_pRasterThread = new WorkerThread();
+	}
+
+	SoftwareRenderer::~SoftwareRenderer()
+	{
+		SDL_FreeSurface(m_pBackBuffer);
+
+		delete[] m_pTiledBackBufferPixels;
+		delete[] m_pColorBufferPixels;
+		delete[] m_pDepthBuffer;
+		delete[] m_pCoarseDepthBufferPixels;
+		delete[] m_pOccluderDepthBuffer;
+		delete[] m_pOccluderCoverage;
+		delete[] m_pOccluderCoverageDepths;
+		delete[] m_pDepthBlockStates;
+		delete[] m_pDepthBlockPlanes;
+		delete[] m_pVisibilityBuffer;
+		delete[] m_pShadingCellTriangles;
+		delete[] m_pShadingCellColors;
+		delete[] m_pSamplePixels;
+		delete[] m_pSampleColorBufferPixels;
+		delete[] m_pTiles;
+
+		delete m_pRasterThread;
+		delete m_pThreadPool;
+	}
+
+	void SoftwareRenderer::Update(float elapsedTime)
+	{
+		UpdateRenderScale(elapsedTime);
+
+		// the changes of this frame are known by now
+		m_AreTrianglesOutdated = m_HasAssemblyChanged;
+		m_HasAssemblyChanged = false;
+	}
+	void SoftwareRenderer::Render() const
+	{
+		SDL_LockSurface(m_pBackBuffer);
+
+		// triangles assembled with other settings can not be rasterized, the frame after a change is not pipelined
+		if (m_UsePipelinedFrames && m_AreTrianglesOutdated == false)
+		{
+			// the previous frame is rasterized on the pool, the geometry of this one runs here
+			const std::function<void()> rasterizeFrame{ [this] { RasterizeFrame(); } };
+			m_pRasterThread->Start(rasterizeFrame);
+
+			ProcessGeometry(true);
+
+			m_pRasterThread->Wait();
+
+			for (const auto& mesh : *m_pMeshToShadedEffectMap | std::views::keys)
+			{
+				std::swap(mesh->trianglesOut, mesh->pendingTrianglesOut);
+			}
+		}
+		else
+		{
+			ProcessGeometry(false);
+
+			RasterizeFrame();
+		}
+
+		//@END
+		//Update SDL Surface
+		SDL_UnlockSurface(m_pBackBuffer);
+		if (m_Width == m_WindowWidth && m_Height == m_WindowHeight)
+			SDL_BlitSurface(m_pBackBuffer, 0, m_pFrontBuffer, 0);
+		else
+			SDL_BlitScaled(m_pBackBuffer, 0, m_pFrontBuffer, 0);
+		SDL_UpdateWindowSurface(m_pWindow);
+	}
+	void SoftwareRenderer::ProcessGeometry(bool isPipelined) const
+	{
+		const auto processMesh = [this, isPipelined](Mesh& mesh)
+			{
+				VertexTransformationFunction(mesh, isPipelined == false);
+				AssembleTriangles(mesh, isPipelined ? mesh.pendingTrianglesOut : mesh.trianglesOut);
+			};
+
+		// culling only pays off when there are other meshes to skip
+		const bool hasOccludees = std::ranges::any_of(*m_pMeshToShadedEffectMap | std::views::keys, [](const Mesh* pMesh) { return pMesh->isOccluder == false; });
+
+		if (m_UseOcclusionCulling == false || hasOccludees == false)
+		{
+			for (const auto& mesh : *m_pMeshToShadedEffectMap | std::views::keys)
+			{
+				processMesh(*mesh);
+			}
+			return;
+		}
+
+		// the occluders first, the other meshes are tested against them
+		std::fill_n(m_pOccluderDepthBuffer, m_NrOfDepthBlocksX * m_NrOfDepthBlocksY, FLT_MAX);
+		std::fill_n(m_pOccluderCoverage, m_NrOfDepthBlocksX * m_NrOfDepthBlocksY, 0);
+		std::fill_n(m_pOccluderCoverageDepths, m_NrOfDepthBlocksX * m_NrOfDepthBlocksY, 0.f);
+
+		for (const auto& mesh : *m_pMeshToShadedEffectMap | std::views::keys)
+		{
+			if (mesh->isOccluder == false)
+				continue;
+
+			processMesh(*mesh);
+
+			const std::vector<TriangleOut>& triangles = isPipelined ? mesh->pendingTrianglesOut : mesh->trianglesOut;
+
+			// rows of blocks are independent, unless the pool is rasterizing the previous frame
+			if (isPipelined)
+			{
+				for (const TriangleOut& triangle : triangles)
+				{
+					RasterizeOccluder(triangle, 0, m_NrOfDepthBlocksY);
+				}
+				continue;
+			}
+
+			m_pThreadPool->ParallelFor(static_cast<uint32_t>(m_NrOfDepthBlocksY), [&](uint32_t blockY)
+				{
+					for (const TriangleOut& triangle : triangles)
+					{
+						if (triangle.maxY >= static_cast<INT>(blockY) * DEPTH_BLOCK_SIZE && triangle.minY < static_cast<INT>(blockY + 1) * DEPTH_BLOCK_SIZE)
+							RasterizeOccluder(triangle, blockY, blockY + 1);
+					}
+				});
+		}
+
+		// a hidden mesh is not transformed at all
+		for (const auto& mesh : *m_pMeshToShadedEffectMap | std::views::keys)
+		{
+			if (mesh->isOccluder)
+				continue;
+
+			if (IsMeshOccluded(*mesh))
+				(isPipelined ? mesh->pendingTrianglesOut : mesh->trianglesOut).clear();
+			else
+				processMesh(*mesh);
+		}
+	}
+	void SoftwareRenderer::RasterizeOccluder(const TriangleOut& triangle, INT minBlockY, INT maxBlockY) const
+	{
+		// nothing of the triangle is farther than its farthest vertex
+		const float maxDepth = std::max({ triangle.v0.position.z, triangle.v1.position.z, triangle.v2.position.z });
+
+		EdgeSetup edges{};
+
+		// only the rows of blocks in [minBlockY, maxBlockY) are written
+		edges.minX = std::max(triangle.minX, 0);
+		edges.maxX = std::min(triangle.maxX + 1, m_Width);
+		edges.minY = std::max(triangle.minY, minBlockY * DEPTH_BLOCK_SIZE);
+		edges.maxY = std::min({ triangle.maxY + 1, maxBlockY * DEPTH_BLOCK_SIZE, m_Height });
+
+		if (edges.minX >= edges.maxX || edges.minY >= edges.maxY)
+			return;
+
+		// the edges of the rasterizer, so the occluder covers the pixels it is drawn in
+		SetupEdges(triangle, edges);
+
+		for (INT blockY = edges.minY / DEPTH_BLOCK_SIZE; blockY <= (edges.maxY - 1) / DEPTH_BLOCK_SIZE; ++blockY)
+		{
+			for (INT blockX = edges.minX / DEPTH_BLOCK_SIZE; blockX <= (edges.maxX - 1) / DEPTH_BLOCK_SIZE; ++blockX)
+			{
+				const INT blockIdx = blockX + blockY * m_NrOfDepthBlocksX;
+
+				// already hidden behind something nearer
+				if (maxDepth >= m_pOccluderDepthBuffer[blockIdx])
+					continue;
+
+				const INT blockMinX = std::max(blockX * DEPTH_BLOCK_SIZE, edges.minX);
+				const INT blockMaxX = std::min((blockX + 1) * DEPTH_BLOCK_SIZE, edges.maxX);
+				const INT blockMinY = std::max(blockY * DEPTH_BLOCK_SIZE, edges.minY);
+				const INT blockMaxY = std::min((blockY + 1) * DEPTH_BLOCK_SIZE, edges.maxY);
+
+				const BlockCoverage blockCoverage = ClassifyBlock(edges, blockMinX, blockMinY, blockMaxX, blockMaxY);
+
+				if (blockCoverage == BlockCoverage::outside)
+					continue;
+
+				// a bit per pixel, only the blocks on an edge evaluate the edges
+				uint64_t coverage{};
+				for (INT py = blockMinY; py < blockMaxY; ++py)
+				{
+					uint64_t rowCoverage{ (1ull << (blockMaxX - blockMinX)) - 1 };
+
+					if (blockCoverage == BlockCoverage::partial)
+					{
+						int64_t edgeValues[3];
+						for (int i{}; i < 3; ++i)
+						{
+							edgeValues[i] = edges.origins[i] + (blockMinX - edges.minX) * edges.stepsX[i] + (py - edges.minY) * edges.stepsY[i];
+						}
+
+						uint64_t spanCoverage{};
+						for (INT px = blockMinX; px < blockMaxX; px += COVERAGE_SPAN)
+						{
+							spanCoverage |= static_cast<uint64_t>(EvaluateEdgeFunctions(edgeValues, edges.laneOffsets)) << (px - blockMinX);
+
+							for (int i{}; i < 3; ++i)
+							{
+								edgeValues[i] += COVERAGE_SPAN * edges.stepsX[i];
+							}
+						}
+
+						rowCoverage &= spanCoverage;
+					}
+
+					coverage |= rowCoverage << (blockMinX % DEPTH_BLOCK_SIZE + (py % DEPTH_BLOCK_SIZE) * DEPTH_BLOCK_SIZE);
+				}
+
+				if (coverage == 0)
+					continue;
+
+				m_pOccluderCoverage[blockIdx] |= coverage;
+				m_pOccluderCoverageDepths[blockIdx] = std::max(m_pOccluderCoverageDepths[blockIdx], maxDepth);
+
+				// pixels outside of the screen count as covered
+				const INT nrOfColumns = std::min(m_Width - blockX * DEPTH_BLOCK_SIZE, DEPTH_BLOCK_SIZE);
+				const INT nrOfRows = std::min(m_Height - blockY * DEPTH_BLOCK_SIZE, DEPTH_BLOCK_SIZE);
+				uint64_t offScreenMask = nrOfRows < DEPTH_BLOCK_SIZE ? UINT64_MAX << (nrOfRows * DEPTH_BLOCK_SIZE) : 0;
+				for (INT row{}; row < nrOfRows && nrOfColumns < DEPTH_BLOCK_SIZE; ++row)
+				{
+					offScreenMask |= ((0xFFull << nrOfColumns) & 0xFF) << (row * DEPTH_BLOCK_SIZE);
+				}
+
+				// complete: nothing behind the farthest triangle is visible, start over for a nearer one
+				if ((m_pOccluderCoverage[blockIdx] | offScreenMask) == UINT64_MAX)
+				{
+					m_pOccluderDepthBuffer[blockIdx] = std::min(m_pOccluderDepthBuffer[blockIdx], m_pOccluderCoverageDepths[blockIdx]);
+					m_pOccluderCoverage[blockIdx] = 0;
+					m_pOccluderCoverageDepths[blockIdx] = 0.f;
+				}
+			}
+		}
+	}
+	bool SoftwareRenderer::IsMeshOccluded(const Mesh& mesh) const
+	{
+		const Matrix worldViewProjectionMatrix = mesh.GetWorldMatrix() * m_pCamera->GetViewMatrix() * m_pCamera->GetProjectionMatrix();
+
+		// screen rectangle and nearest depth of the bounds
+		float minX{ FLT_MAX };
+		float minY{ FLT_MAX };
+		float maxX{ -FLT_MAX };
+		float maxY{ -FLT_MAX };
+		float minDepth{ FLT_MAX };
+
+		for (int corner{}; corner < 8; ++corner)
+		{
+			const Vector4 position = worldViewProjectionMatrix.TransformPoint(Vector4{
+				(corner & 1) ? mesh.boundsMax.x : mesh.boundsMin.x,
+				(corner & 2) ? mesh.boundsMax.y : mesh.boundsMin.y,
+				(corner & 4) ? mesh.boundsMax.z : mesh.boundsMin.z,
+				1.f });
+
+			// bounds past the near plane can cover anything
+			if (position.z < 0)
+				return false;
+
+			const float invW = 1.f / position.w;
+			const float x = (position.x * invW + 1) * 0.5f * (float)m_Width;
+			const float y = (1 - position.y * invW) * 0.5f * (float)m_Height;
+
+			minX = std::min(minX, x);
+			minY = std::min(minY, y);
+			maxX = std::max(maxX, x);
+			maxY = std::max(maxY, y);
+			minDepth = std::min(minDepth, position.z * invW);
+		}
+
+		// hidden when every block it touches has an occluder in front of it
+		const INT firstBlockX = static_cast<INT>(std::max(minX, 0.f)) / DEPTH_BLOCK_SIZE;
+		const INT firstBlockY = static_cast<INT>(std::max(minY, 0.f)) / DEPTH_BLOCK_SIZE;
+		const INT lastBlockX = std::min(static_cast<INT>(std::clamp(maxX, 0.f, (float)m_Width)) / DEPTH_BLOCK_SIZE, m_NrOfDepthBlocksX - 1);
+		const INT lastBlockY = std::min(static_cast<INT>(std::clamp(maxY, 0.f, (float)m_Height)) / DEPTH_BLOCK_SIZE, m_NrOfDepthBlocksY - 1);
+
+		for (INT blockY = firstBlockY; blockY <= lastBlockY; ++blockY)
+		{
+			for (INT blockX = firstBlockX; blockX <= lastBlockX; ++blockX)
+			{
+				if (m_pOccluderDepthBuffer[blockX + blockY * m_NrOfDepthBlocksX] >= minDepth)
+					return false;
+			}
+		}
+
+		return true;
+	}
+	void SoftwareRenderer::RasterizeFrame() const
+	{
+		// binned triangles clear the tiles they touch, otherwise everything is cleared up front
+		if (m_UseTileBinning)
+		{
+			for (int i{}; i < m_NrOfTilesX * m_NrOfTilesY; ++i)
+			{
+				m_pTiles[i].isCleared = false;
+			}
+		}
+		else
+		{
+			if (m_CurrentDepthFormat == DepthFormat::planeCompressed)
+				std::fill_n(m_pDepthBlockStates, m_NrOfDepthBlocksX * m_NrOfDepthBlocksY, DepthBlockState::cleared);
+			else
+				ClearDepth(0, m_NrOfBufferPixels * GetNrOfSamples());
+
+			std::fill_n(m_pCoarseDepthBufferPixels, m_NrOfDepthBlocksX * m_NrOfDepthBlocksY, FLT_MAX);
+
+			if (m_CurrentRenderPath == RenderPath::visibilityBuffer)
+				std::fill_n(m_pVisibilityBuffer, m_NrOfBufferPixels * GetNrOfSamples(), INVALID_TRIANGLE_ID);
+
+			if (m_CurrentShadingRate != ShadingRate::rate1x1)
+				std::fill_n(m_pShadingCellTriangles, m_NrOfDepthBlocksX * m_NrOfDepthBlocksY * SHADING_CELLS_PER_BLOCK, INVALID_TRIANGLE_ID);
+
+			ClearBackground();
+		}
+
+		// every pass reuses the assembled triangles
+		const auto renderMeshes = [this](RasterPass pass)
+			{
+				uint32_t firstTriangleId{};
+				for (const auto& mesh : *m_pMeshToShadedEffectMap | std::views::keys)
+				{
+					RenderTriangleList(*mesh, firstTriangleId, pass);
+					firstTriangleId += static_cast<uint32_t>(mesh->trianglesOut.size());
+				}
+			};
+
+		if (m_CurrentRenderPath == RenderPath::depthPrepass)
+		{
+			renderMeshes(RasterPass::depthOnly);
+			renderMeshes(RasterPass::equalDepthColor);
+		}
+		else
+		{
+			renderMeshes(RasterPass::depthAndColor);
+		}
+
+		// the tiles no triangle touched still hold the previous frame
+		if (m_UseTileBinning)
+		{
+			m_pThreadPool->ParallelFor(static_cast<uint32_t>(m_NrOfTilesX * m_NrOfTilesY), [&](uint32_t tileIdx)
+				{
+					if (m_pTiles[tileIdx].isCleared == false)
+						ClearTile(m_pTiles[tileIdx]);
+				});
+		}
+
+		if (m_CurrentRenderPath == RenderPath::visibilityBuffer)
+			ResolveVisibilityBuffer();
+		else if (m_UseMultisampling)
+			ResolveSamples();
+
+		if (m_UseHdrColorBuffer)
+			ResolveColorBuffer();
+
+		if (m_UseTiledFrameBuffer)
+			DetileBackBuffer();
+
+		if (m_CurrentShadingRate == ShadingRate::adaptive)
+			UpdateShadingRates();
+	}
+	void SoftwareRenderer::SetBackGroundColor(const ColorRGB& color)
+	{
+		m_BackGroundColor = color;
+	}
+	void SoftwareRenderer::SetVehicleTextures(const Texture* pDiffuse, const Texture* pNormalMap, const Texture* pGlossinessMap, const Texture* pSpecularMap)
+	{
+		m_pVehicleDiffuse = pDiffuse;
+		m_pVehicleNormalMap = pNormalMap;
+		m_pVehicleGlossinessMap = pGlossinessMap;
+		m_pVehicleSpecularMap = pSpecularMap;
+	}
+	void SoftwareRenderer::InvalidateTriangles()
+	{
+		m_HasAssemblyChanged = true;
+	}
+	void SoftwareRenderer::CycleCullMode()
+	{
+		switch (m_CurrentCullMode)
+		{
+		case CullMode::back:
+			m_CurrentCullMode = CullMode::front;
+			break;
+		case CullMode::front:
+			m_CurrentCullMode = CullMode::none;
+			break;
+		case CullMode::none:
+			m_CurrentCullMode = CullMode::back;
+			break;
+		}
+
+		m_HasAssemblyChanged = true;
+	}
+	void SoftwareRenderer::CycleShadingMode()
+	{
+		HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+		switch (m_CurrentShadingMode)
+		{
+		case ShadingMode::observedArea:
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Shading Mode = DIFFUSE\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_CurrentShadingMode = ShadingMode::diffuse;
+			break;
+		case ShadingMode::diffuse:
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Shading Mode = SPECULAR\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_CurrentShadingMode = ShadingMode::specular;
+
+			break;
+		case ShadingMode::specular:
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Shading Mode = COMBINED\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_CurrentShadingMode = ShadingMode::combined;
+
+			break;
+		case ShadingMode::combined:
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Shading Mode = OBSERVED AREA\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_CurrentShadingMode = ShadingMode::observedArea;
+			break;
+		}
+	}
+	void SoftwareRenderer::ToggleNormalMap()
+	{
+		HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+		if (m_EnableNormalMap == true)
+		{
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) NormalMap OFF\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_EnableNormalMap = false;
+		}
+		else if (m_EnableNormalMap == false)
+		{
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) NormalMap ON\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_EnableNormalMap = true;
+		}
+	}
+	void SoftwareRenderer::ToggleDepthBufferVisualization()
+	{
+		HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+		if (m_DepthBufferVisualization == true)
+		{
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) DepthBuffer Visualization OFF\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_DepthBufferVisualization = false;
+		}
+		else if (m_DepthBufferVisualization == false)
+		{
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) DepthBuffer Visualization ON\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_DepthBufferVisualization = true;
+		}
+	}
+	void SoftwareRenderer::ToggleBoundingBoxVisualization()
+	{
+		HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+		if (m_BoundingBoxVisualization == true)
+		{
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) DepthBuffer Visualization OFF\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_BoundingBoxVisualization = false;
+		}
+		else if (m_BoundingBoxVisualization == false)
+		{
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) DepthBuffer Visualization ON\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_BoundingBoxVisualization = true;
+		}
+	}
+	void SoftwareRenderer::ToggleTileBinning()
+	{
+		HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+		if (m_UseTileBinning == true)
+		{
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Tile Binning OFF\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_UseTileBinning = false;
+		}
+		else if (m_UseTileBinning == false)
+		{
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Tile Binning ON (" << m_pThreadPool->GetNrOfThreads() << " threads)\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_UseTileBinning = true;
+		}
+	}
+	void SoftwareRenderer::ToggleHierarchicalDepth()
+	{
+		HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+		if (m_UseHierarchicalDepth == true)
+		{
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Hierarchical DepthBuffer OFF\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_UseHierarchicalDepth = false;
+		}
+		else if (m_UseHierarchicalDepth == false)
+		{
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Hierarchical DepthBuffer ON\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_UseHierarchicalDepth = true;
+		}
+	}
+	void SoftwareRenderer::CycleRenderPath()
+	{
+		HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+		switch (m_CurrentRenderPath)
+		{
+		case RenderPath::forward:
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Render Path = VISIBILITY BUFFER\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_CurrentRenderPath = RenderPath::visibilityBuffer;
+			break;
+		case RenderPath::visibilityBuffer:
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Render Path = DEPTH PREPASS\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_CurrentRenderPath = RenderPath::depthPrepass;
+			break;
+		case RenderPath::depthPrepass:
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Render Path = FORWARD\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_CurrentRenderPath = RenderPath::forward;
+			break;
+		}
+	}
+	void SoftwareRenderer::CycleRasterTraversal()
+	{
+		HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+		switch (m_CurrentRasterTraversal)
+		{
+		case RasterTraversal::hierarchical:
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Raster Traversal = BOUNDING BOX\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_CurrentRasterTraversal = RasterTraversal::boundingBox;
+			break;
+		case RasterTraversal::boundingBox:
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Raster Traversal = SCANLINE\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_CurrentRasterTraversal = RasterTraversal::scanline;
+			break;
+		case RasterTraversal::scanline:
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Raster Traversal = HIERARCHICAL\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_CurrentRasterTraversal = RasterTraversal::hierarchical;
+			break;
+		}
+	}
+	void SoftwareRenderer::TogglePipelinedFrames()
+	{
+		HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+		if (m_UsePipelinedFrames == true)
+		{
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Pipelined Frames OFF\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_UsePipelinedFrames = false;
+		}
+		else if (m_UsePipelinedFrames == false)
+		{
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Pipelined Frames ON\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_UsePipelinedFrames = true;
+		}
+	}
+	void SoftwareRenderer::ToggleHdrColorBuffer()
+	{
+		HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+		if (m_UseHdrColorBuffer == true)
+		{
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) HDR ColorBuffer OFF\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_UseHdrColorBuffer = false;
+		}
+		else if (m_UseHdrColorBuffer == false)
+		{
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) HDR ColorBuffer ON\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_UseHdrColorBuffer = true;
+		}
+	}
+	void SoftwareRenderer::CycleToneMapping()
+	{
+		HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+		switch (m_CurrentToneMapping)
+		{
+		case ToneMapping::maxToOne:
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Tone Mapping = REINHARD\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_CurrentToneMapping = ToneMapping::reinhard;
+			break;
+		case ToneMapping::reinhard:
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Tone Mapping = ACES\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_CurrentToneMapping = ToneMapping::aces;
+			break;
+		case ToneMapping::aces:
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Tone Mapping = MAX TO ONE\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_CurrentToneMapping = ToneMapping::maxToOne;
+			break;
+		}
+	}
+	void SoftwareRenderer::CycleDepthFormat()
+	{
+		HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+		switch (m_CurrentDepthFormat)
+		{
+		case DepthFormat::float32:
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Depth Format = UNORM24\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_CurrentDepthFormat = DepthFormat::unorm24;
+			break;
+		case DepthFormat::unorm24:
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Depth Format = UNORM16\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_CurrentDepthFormat = DepthFormat::unorm16;
+			break;
+		case DepthFormat::unorm16:
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Depth Format = PLANE COMPRESSED\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_CurrentDepthFormat = DepthFormat::planeCompressed;
+			break;
+		case DepthFormat::planeCompressed:
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Depth Format = FLOAT32\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_CurrentDepthFormat = DepthFormat::float32;
+			break;
+		}
+	}
+	void SoftwareRenderer::ToggleTiledFrameBuffer()
+	{
+		HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+		if (m_UseTiledFrameBuffer == true)
+		{
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Tiled FrameBuffer OFF\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_UseTiledFrameBuffer = false;
+		}
+		else if (m_UseTiledFrameBuffer == false)
+		{
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Tiled FrameBuffer ON\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_UseTiledFrameBuffer = true;
+		}
+	}
+	void SoftwareRenderer::ToggleMultisampling()
+	{
+		HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+		if (m_UseMultisampling == true)
+		{
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) MSAA 4x OFF\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_UseMultisampling = false;
+		}
+		else if (m_UseMultisampling == false)
+		{
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) MSAA 4x ON\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_UseMultisampling = true;
+		}
+
+		// the bounds and the stamps of the triangles depend on it
+		m_HasAssemblyChanged = true;
+	}
+	void SoftwareRenderer::ToggleDynamicResolution()
+	{
+		HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+		if (m_UseDynamicResolution == true)
+		{
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Dynamic Resolution OFF\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_UseDynamicResolution = false;
+		}
+		else if (m_UseDynamicResolution == false)
+		{
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Dynamic Resolution ON\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_UseDynamicResolution = true;
+			m_FramesSinceResolutionChange = 0;
+		}
+	}
+	void SoftwareRenderer::CycleShadingRate()
+	{
+		HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+		switch (m_CurrentShadingRate)
+		{
+		case ShadingRate::rate1x1:
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Shading Rate = 2X2\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_CurrentShadingRate = ShadingRate::rate2x2;
+			break;
+		case ShadingRate::rate2x2:
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Shading Rate = 4X4\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_CurrentShadingRate = ShadingRate::rate4x4;
+			break;
+		case ShadingRate::rate4x4:
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Shading Rate = ADAPTIVE\n";
+			SetConsoleTextAttribute(h, 7);
+
+			// full rate until a frame has been measured
+			for (int i{}; i < m_NrOfTilesX * m_NrOfTilesY; ++i)
+			{
+				m_pTiles[i].shadingRate = 1;
+			}
+
+			m_CurrentShadingRate = ShadingRate::adaptive;
+			break;
+		case ShadingRate::adaptive:
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Shading Rate = 1X1\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_CurrentShadingRate = ShadingRate::rate1x1;
+			break;
+		}
+	}
+	void SoftwareRenderer::ToggleOcclusionCulling()
+	{
+		HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+		if (m_UseOcclusionCulling == true)
+		{
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Occlusion Culling OFF\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_UseOcclusionCulling = false;
+		}
+		else if (m_UseOcclusionCulling == false)
+		{
+			SetConsoleTextAttribute(h, 5);
+			std::cout << "**(SOFTWARE) Occlusion Culling ON\n";
+			SetConsoleTextAttribute(h, 7);
+
+			m_UseOcclusionCulling = true;
+		}
+	}
+#pragma region Helpers
+	void SoftwareRenderer::UpdateRenderScale(float elapsedTime)
+	{
+		float renderScale{ 1.f };
+
+		if (m_UseDynamicResolution)
+		{
+			// single slow frames should not change the resolution
+			m_AverageFrameTime += (elapsedTime - m_AverageFrameTime) * FRAME_TIME_SMOOTHING;
+
+			if (++m_FramesSinceResolutionChange < RENDER_SCALE_SETTLE_FRAMES)
+				return;
+
+			const float load = m_AverageFrameTime / TARGET_FRAME_TIME;
+
+			renderScale = m_RenderScale;
+			if (load > 1.f)
+				renderScale = std::floor(m_RenderScale / std::sqrt(load) / RENDER_SCALE_STEP) * RENDER_SCALE_STEP;
+			else if (load < RENDER_SCALE_HEADROOM)
+				renderScale = m_RenderScale + RENDER_SCALE_STEP;
+
+			renderScale = std::clamp(renderScale, MIN_RENDER_SCALE, 1.f);
+		}
+
+		if (renderScale == m_RenderScale)
+			return;
+
+		m_RenderScale = renderScale;
+		m_FramesSinceResolutionChange = 0;
+
+		SetRenderResolution(std::max(static_cast<int>(m_WindowWidth * m_RenderScale + 0.5f), 1),
+			std::max(static_cast<int>(m_WindowHeight * m_RenderScale + 0.5f), 1));
+	}
+	void SoftwareRenderer::SetRenderResolution(int width, int height)
+	{
+		m_Width = width;
+		m_Height = height;
+		m_HasAssemblyChanged = true;
+
+		// presenting stretches the back buffer over the window
+		if (m_pBackBuffer != nullptr)
+			SDL_FreeSurface(m_pBackBuffer);
+
+		m_pBackBuffer = SDL_CreateRGBSurface(0, m_Width, m_Height, 32, 0, 0, 0, 0);
+		m_pBackBufferPixels = (uint32_t*)m_pBackBuffer->pixels;
+
+		m_NrOfDepthBlocksX = (m_Width + DEPTH_BLOCK_SIZE - 1) / DEPTH_BLOCK_SIZE;
+		m_NrOfDepthBlocksY = (m_Height + DEPTH_BLOCK_SIZE - 1) / DEPTH_BLOCK_SIZE;
+		m_NrOfBufferPixels = m_NrOfDepthBlocksX * m_NrOfDepthBlocksY * DEPTH_BLOCK_SIZE * DEPTH_BLOCK_SIZE;
+
+		m_NrOfTilesX = (m_Width + TILE_SIZE - 1) / TILE_SIZE;
+		m_NrOfTilesY = (m_Height + TILE_SIZE - 1) / TILE_SIZE;
+
+		for (int ty{}; ty < m_NrOfTilesY; ++ty)
+		{
+			for (int tx{}; tx < m_NrOfTilesX; ++tx)
+			{
+				Tile& tile = m_pTiles[tx + ty * m_NrOfTilesX];
+				tile.minX = tx * TILE_SIZE;
+				tile.minY = ty * TILE_SIZE;
+				tile.maxX = std::min(tile.minX + TILE_SIZE, m_Width);
+				tile.maxY = std::min(tile.minY + TILE_SIZE, m_Height);
+
+				// the rates were measured on the tiles of the old resolution
+				tile.shadingRate = 1;
+			}
+		}
+	}
+	void SoftwareRenderer::VertexTransformationFunction(Mesh& m, bool isParallel) const
+	{
+		m.verticesOut.Resize(m.vertices.size());
+
+		const Matrix worldViewProjectionMatrix = m.GetWorldMatrix() * m_pCamera->GetViewMatrix() * m_pCamera->GetProjectionMatrix();
+
+		const size_t nrOfVertices = m.vertices.size();
+
+		// every vertex writes only its own slots, the chunks can run in any order
+		if (isParallel == false || nrOfVertices <= VERTEX_CHUNK_SIZE)
+		{
+			TransformVertices(m, worldViewProjectionMatrix, 0, nrOfVertices);
+			return;
+		}
+
+		const uint32_t nrOfChunks = static_cast<uint32_t>((nrOfVertices + VERTEX_CHUNK_SIZE - 1) / VERTEX_CHUNK_SIZE);
+		m_pThreadPool->ParallelFor(nrOfChunks, [&](uint32_t chunkIdx)
+			{
+				const size_t first = chunkIdx * VERTEX_CHUNK_SIZE;
+				TransformVertices(m, worldViewProjectionMatrix, first, std::min(first + VERTEX_CHUNK_SIZE, nrOfVertices));
+			});
+	}
+	void SoftwareRenderer::TransformVertices(Mesh& m, const Matrix& worldViewProjectionMatrix, size_t first, size_t last) const
+	{
+		VertexOutBuffer& out = m.verticesOut;
+		const Matrix worldMatrix = m.GetWorldMatrix();
+
+		// 4 floats at a time, straight out of the vertex structs
+		static_assert(offsetof(Vertex, position) == 0);
+		static_assert(offsetof(Vertex, normal) == offsetof(Vertex, uv) + 2 * sizeof(float));
+		static_assert(offsetof(Vertex, tangent) == offsetof(Vertex, normal) + 3 * sizeof(float));
+		static_assert(offsetof(Vertex, tangent) + 3 * sizeof(float) == sizeof(Vertex));
+
+		constexpr size_t uvOffset{ offsetof(Vertex, uv) / sizeof(float) };
+		constexpr size_t tangentOffset{ offsetof(Vertex, tangent) / sizeof(float) };
+
+		// every row of both matrices broadcast over the lanes
+		__m128 wvp[4][4];
+		__m128 world[3][3];
+		for (int row{}; row < 4; ++row)
+		{
+			wvp[row][0] = _mm_set1_ps(worldViewProjectionMatrix[row].x);
+			wvp[row][1] = _mm_set1_ps(worldViewProjectionMatrix[row].y);
+			wvp[row][2] = _mm_set1_ps(worldViewProjectionMatrix[row].z);
+			wvp[row][3] = _mm_set1_ps(worldViewProjectionMatrix[row].w);
+		}
+		for (int row{}; row < 3; ++row)
+		{
+			world[row][0] = _mm_set1_ps(worldMatrix[row].x);
+			world[row][1] = _mm_set1_ps(worldMatrix[row].y);
+			world[row][2] = _mm_set1_ps(worldMatrix[row].z);
+		}
+
+		// same order of operations as the scalar path
+		const auto transformVector = [](const __m128 (&matrix)[3][3], __m128 x, __m128 y, __m128 z, int column)
+			{
+				return _mm_add_ps(_mm_add_ps(_mm_mul_ps(matrix[0][column], x), _mm_mul_ps(matrix[1][column], y)), _mm_mul_ps(matrix[2][column], z));
+			};
+		const auto normalize = [](__m128& x, __m128& y, __m128& z)
+			{
+				const __m128 magnitude = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+				x = _mm_div_ps(x, magnitude);
+				y = _mm_div_ps(y, magnitude);
+				z = _mm_div_ps(z, magnitude);
+			};
+		const auto computeOutCodes = [](__m128 x, __m128 y, __m128 z, __m128 w, float extent)
+			{
+				const __m128 maxExtent = _mm_mul_ps(_mm_set1_ps(extent), w);
+				const __m128 minExtent = _mm_mul_ps(_mm_set1_ps(-extent), w);
+
+				const auto planeBit = [](__m128 isOutside, uint8_t plane)
+					{
+						return _mm_and_si128(_mm_castps_si128(isOutside), _mm_set1_epi32(plane));
+					};
+
+				__m128i outCodes = planeBit(_mm_cmplt_ps(z, _mm_setzero_ps()), CLIP_NEAR);
+				outCodes = _mm_or_si128(outCodes, planeBit(_mm_cmpgt_ps(z, w), CLIP_FAR));
+				outCodes = _mm_or_si128(outCodes, planeBit(_mm_cmplt_ps(x, minExtent), CLIP_LEFT));
+				outCodes = _mm_or_si128(outCodes, planeBit(_mm_cmpgt_ps(x, maxExtent), CLIP_RIGHT));
+				outCodes = _mm_or_si128(outCodes, planeBit(_mm_cmplt_ps(y, minExtent), CLIP_BOTTOM));
+				outCodes = _mm_or_si128(outCodes, planeBit(_mm_cmpgt_ps(y, maxExtent), CLIP_TOP));
+
+				// one byte per lane
+				outCodes = _mm_packs_epi32(outCodes, outCodes);
+				return _mm_packus_epi16(outCodes, outCodes);
+			};
+
+		size_t i{ first };
+
+		// 4 vertices at a time, every component of the batch in its own register
+		for (; i + 4 <= last; i += 4)
+		{
+			const float* pVertex0 = reinterpret_cast<const float*>(&m.vertices[i]);
+			const float* pVertex1 = reinterpret_cast<const float*>(&m.vertices[i + 1]);
+			const float* pVertex2 = reinterpret_cast<const float*>(&m.vertices[i + 2]);
+			const float* pVertex3 = reinterpret_cast<const float*>(&m.vertices[i + 3]);
+
+			// x y z (color r)
+			__m128 x = _mm_loadu_ps(pVertex0);
+			__m128 y = _mm_loadu_ps(pVertex1);
+			__m128 z = _mm_loadu_ps(pVertex2);
+			__m128 colorR = _mm_loadu_ps(pVertex3);
+			_MM_TRANSPOSE4_PS(x, y, z, colorR);
+
+			// u v normal x normal y
+			__m128 u = _mm_loadu_ps(pVertex0 + uvOffset);
+			__m128 v = _mm_loadu_ps(pVertex1 + uvOffset);
+			__m128 normalX = _mm_loadu_ps(pVertex2 + uvOffset);
+			__m128 normalY = _mm_loadu_ps(pVertex3 + uvOffset);
+			_MM_TRANSPOSE4_PS(u, v, normalX, normalY);
+
+			// normal z tangent x y z
+			__m128 normalZ = _mm_loadu_ps(pVertex0 + tangentOffset - 1);
+			__m128 tangentX = _mm_loadu_ps(pVertex1 + tangentOffset - 1);
+			__m128 tangentY = _mm_loadu_ps(pVertex2 + tangentOffset - 1);
+			__m128 tangentZ = _mm_loadu_ps(pVertex3 + tangentOffset - 1);
+			_MM_TRANSPOSE4_PS(normalZ, tangentX, tangentY, tangentZ);
+
+			// to Clip-Space, the perspective divide happens after clipping
+			__m128 position[4];
+			for (int column{}; column < 4; ++column)
+			{
+				position[column] = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(wvp[0][column], x), _mm_mul_ps(wvp[1][column], y)),
+					_mm_mul_ps(wvp[2][column], z)), wvp[3][column]);
+			}
+
+			__m128 viewDirectionX = position[0];
+			__m128 viewDirectionY = position[1];
+			__m128 viewDirectionZ = position[2];
+			normalize(viewDirectionX, viewDirectionY, viewDirectionZ);
+
+			__m128 worldNormalX = transformVector(world, normalX, normalY, normalZ, 0);
+			__m128 worldNormalY = transformVector(world, normalX, normalY, normalZ, 1);
+			__m128 worldNormalZ = transformVector(world, normalX, normalY, normalZ, 2);
+			normalize(worldNormalX, worldNormalY, worldNormalZ);
+
+			__m128 worldTangentX = transformVector(world, tangentX, tangentY, tangentZ, 0);
+			__m128 worldTangentY = transformVector(world, tangentX, tangentY, tangentZ, 1);
+			__m128 worldTangentZ = transformVector(world, tangentX, tangentY, tangentZ, 2);
+			normalize(worldTangentX, worldTangentY, worldTangentZ);
+
+			_mm_store_ps(out.pPositionX + i, position[0]);
+			_mm_store_ps(out.pPositionY + i, position[1]);
+			_mm_store_ps(out.pPositionZ + i, position[2]);
+			_mm_store_ps(out.pPositionW + i, position[3]);
+
+			_mm_store_ps(out.pU + i, u);
+			_mm_store_ps(out.pV + i, v);
+
+			_mm_store_ps(out.pNormalX + i, worldNormalX);
+			_mm_store_ps(out.pNormalY + i, worldNormalY);
+			_mm_store_ps(out.pNormalZ + i, worldNormalZ);
+
+			_mm_store_ps(out.pTangentX + i, worldTangentX);
+			_mm_store_ps(out.pTangentY + i, worldTangentY);
+			_mm_store_ps(out.pTangentZ + i, worldTangentZ);
+
+			_mm_store_ps(out.pViewDirectionX + i, viewDirectionX);
+			_mm_store_ps(out.pViewDirectionY + i, viewDirectionY);
+			_mm_store_ps(out.pViewDirectionZ + i, viewDirectionZ);
+
+			_mm_storeu_si32(out.pFrustumOutCodes + i, computeOutCodes(position[0], position[1], position[2], position[3], 1.f));
+			_mm_storeu_si32(out.pGuardBandOutCodes + i, computeOutCodes(position[0], position[1], position[2], position[3], GUARD_BAND));
+		}
+
+		// the vertices that do not fill a batch
+		for (; i < last; ++i)
+		{
+			const Vertex& v = m.vertices[i];
+
+			// to Clip-Space, the perspective divide happens after clipping
+			const Vector4 position = worldViewProjectionMatrix.TransformPoint(v.position.ToVector4());
+			const Vector3 viewDirection = Vector3{ position.GetXYZ() }.Normalized();
+			const Vector3 normal = worldMatrix.TransformVector(v.normal).Normalized();
+			const Vector3 tangent = worldMatrix.TransformVector(v.tangent).Normalized();
+
+			out.pPositionX[i] = position.x;
+			out.pPositionY[i] = position.y;
+			out.pPositionZ[i] = position.z;
+			out.pPositionW[i] = position.w;
+
+			out.pU[i] = v.uv.x;
+			out.pV[i] = v.uv.y;
+
+			out.pNormalX[i] = normal.x;
+			out.pNormalY[i] = normal.y;
+			out.pNormalZ[i] = normal.z;
+
+			out.pTangentX[i] = tangent.x;
+			out.pTangentY[i] = tangent.y;
+			out.pTangentZ[i] = tangent.z;
+
+			out.pViewDirectionX[i] = viewDirection.x;
+			out.pViewDirectionY[i] = viewDirection.y;
+			out.pViewDirectionZ[i] = viewDirection.z;
+
+			// shared vertices are classified once
+			out.pFrustumOutCodes[i] = ComputeOutCode(position, 1.f);
+			out.pGuardBandOutCodes[i] = ComputeOutCode(position, GUARD_BAND);
+		}
+	}
+	void SoftwareRenderer::RenderTriangleList(const Mesh& mesh, uint32_t firstTriangleId, RasterPass pass) const
+	{
+		if (m_UseTileBinning == false)
+		{
+			for (uint32_t i{}; i < static_cast<uint32_t>(mesh.trianglesOut.size()); ++i)
+			{
+				RasterizeTriangle(mesh.trianglesOut[i], firstTriangleId + i, pass, 0, 0, m_Width, m_Height);
+			}
+			return;
+		}
+
+		BinTriangles(mesh);
+
+		// tiles only touch their own pixels, the bins keep the submission order
+		m_pThreadPool->ParallelFor(static_cast<uint32_t>(m_NrOfTilesX * m_NrOfTilesY), [&](uint32_t tileIdx)
+			{
+				Tile& tile = m_pTiles[tileIdx];
+
+				if (tile.triangleIndices.empty() == false && tile.isCleared == false)
+					ClearTile(tile);
+
+				for (const uint32_t triangleIdx : tile.triangleIndices)
+				{
+					RasterizeTriangle(mesh.trianglesOut[triangleIdx], firstTriangleId + triangleIdx, pass, tile.minX, tile.minY, tile.maxX, tile.maxY);
+				}
+			});
+	}
+	void SoftwareRenderer::AssembleTriangles(const Mesh& mesh, std::vector<TriangleOut>& trianglesOut) const
+	{
+		trianglesOut.clear();
+		trianglesOut.reserve(mesh.indices.size() / 3);
+
+		const VertexOutBuffer& verticesOut = mesh.verticesOut;
+
+		for (size_t i{}; i < mesh.indices.size(); i += 3)
+		{
+			const uint32_t index0 = mesh.indices[i];
+			const uint32_t index1 = mesh.indices[i + 1];
+			const uint32_t index2 = mesh.indices[i + 2];
+
+			// frustum culling, only reject triangles completely outside one plane
+			if ((verticesOut.pFrustumOutCodes[index0] & verticesOut.pFrustumOutCodes[index1] & verticesOut.pFrustumOutCodes[index2]) != 0)
+				continue;
+
+			// only triangles crossing the near plane or the guard band are clipped
+			const uint8_t clipPlanes = (verticesOut.pGuardBandOutCodes[index0]
+				| verticesOut.pGuardBandOutCodes[index1]
+				| verticesOut.pGuardBandOutCodes[index2]) & ~CLIP_FAR;
+
+			// attributes are only gathered for the surviving triangles
+			const VertexOut vOut0 = verticesOut.Fetch(index0);
+			const VertexOut vOut1 = verticesOut.Fetch(index1);
+			const VertexOut vOut2 = verticesOut.Fetch(index2);
+
+			if (clipPlanes == 0)
+			{
+				EmitTriangle(trianglesOut, vOut0, vOut1, vOut2);
+				continue;
+			}
+
+			VertexOut polygon[MAX_CLIPPED_VERTICES]{ vOut0, vOut1, vOut2 };
+			const int nrOfVertices = ClipPolygon(polygon, 3, clipPlanes);
+
+			// triangulate the clipped polygon as a fan
+			for (int v{ 1 }; v < nrOfVertices - 1; ++v)
+			{
+				EmitTriangle(trianglesOut, polygon[0], polygon[v], polygon[v + 1]);
+			}
+		}
+	}
+	void SoftwareRenderer::EmitTriangle(std::vector<TriangleOut>& trianglesOut, const VertexOut& vOut0, const VertexOut& vOut1, const VertexOut& vOut2) const
+	{
+		TriangleOut triangle{};
+		triangle.v0 = vOut0;
+		triangle.v1 = vOut1;
+		triangle.v2 = vOut2;
+
+		// from Clip space to NDC space
+		PerspectiveDivide(triangle.v0);
+		PerspectiveDivide(triangle.v1);
+		PerspectiveDivide(triangle.v2);
+
+		// from NDC space to Raster space
+		NDCToRaster(triangle.v0);
+		NDCToRaster(triangle.v1);
+		NDCToRaster(triangle.v2);
+
+		const int64_t x0 = static_cast<int64_t>(triangle.v0.position.x * SUBPIXEL_SCALE);
+		const int64_t y0 = static_cast<int64_t>(triangle.v0.position.y * SUBPIXEL_SCALE);
+		const int64_t x1 = static_cast<int64_t>(triangle.v1.position.x * SUBPIXEL_SCALE);
+		const int64_t y1 = static_cast<int64_t>(triangle.v1.position.y * SUBPIXEL_SCALE);
+		const int64_t x2 = static_cast<int64_t>(triangle.v2.position.x * SUBPIXEL_SCALE);
+		const int64_t y2 = static_cast<int64_t>(triangle.v2.position.y * SUBPIXEL_SCALE);
+
+		// culling on the exact fixed point area, positive is front facing
+		const int64_t areaTriangle = (x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0);
+
+		if (areaTriangle == 0)
+			return;
+
+		if (m_CurrentCullMode == CullMode::back && areaTriangle < 0)
+			return;
+
+		if (m_CurrentCullMode == CullMode::front && areaTriangle > 0)
+			return;
+
+		// flip the triangles facing away, the rasterizer handles one winding
+		if (areaTriangle < 0)
+			std::swap(triangle.v1, triangle.v2);
+
+		// create bounding box for triangle
+		constexpr int64_t halfPixel{ SUBPIXEL_SCALE / 2 };
+		const int64_t sampleExtent = m_UseMultisampling ? MSAA_SAMPLE_EXTENT : 0;
+
+		triangle.minX = static_cast<int>((std::min({ x0, x1, x2 }) - halfPixel - sampleExtent + SUBPIXEL_SCALE - 1) >> SUBPIXEL_BITS);
+		triangle.maxX = static_cast<int>((std::max({ x0, x1, x2 }) - halfPixel + sampleExtent) >> SUBPIXEL_BITS);
+		triangle.minY = static_cast<int>((std::min({ y0, y1, y2 }) - halfPixel - sampleExtent + SUBPIXEL_SCALE - 1) >> SUBPIXEL_BITS);
+		triangle.maxY = static_cast<int>((std::max({ y0, y1, y2 }) - halfPixel + sampleExtent) >> SUBPIXEL_BITS);
+
+		// sub-pixel triangles in between the pixel centers cover nothing
+		if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+			return;
+
+		// check if bounding box overlaps the screen
+		if (triangle.maxX < 0 || triangle.minX >= m_Width)
+			return;
+
+		if (triangle.maxY < 0 || triangle.minY >= m_Height)
+			return;
+
+		// small triangles get their coverage right away, multisampled ones take the sample traversal
+		triangle.stampCoverage = 0;
+		if (triangle.maxX - triangle.minX < STAMP_SIZE && triangle.maxY - triangle.minY < STAMP_SIZE && m_UseMultisampling == false)
+		{
+			EdgeSetup edges{};
+			edges.minX = triangle.minX;
+			edges.minY = triangle.minY;
+			edges.maxX = triangle.minX + STAMP_SIZE;
+			edges.maxY = triangle.minY + STAMP_SIZE;
+			SetupEdges(triangle, edges);
+
+			triangle.stampCoverage = EvaluateStamp(edges, triangle.maxY - triangle.minY + 1);
+			if (triangle.stampCoverage == 0)
+				return;
+		}
+
+		// the winding is positive by now
+		SetupTriangle(triangle, std::abs(areaTriangle));
+
+		trianglesOut.emplace_back(triangle);
+	}
+	void SoftwareRenderer::SetupTriangle(TriangleOut& triangle, int64_t fixedArea) const
+	{
+		const VertexOut& vOut0 = triangle.v0;
+		const VertexOut& vOut1 = triangle.v1;
+		const VertexOut& vOut2 = triangle.v2;
+
+		const float dx1 = vOut1.position.x - vOut0.position.x;
+		const float dy1 = vOut1.position.y - vOut0.position.y;
+		const float dx2 = vOut2.position.x - vOut0.position.x;
+		const float dy2 = vOut2.position.y - vOut0.position.y;
+
+		// from the exact area, the float one can round to 0 for slivers
+		const float invArea = SUBPIXEL_SCALE * SUBPIXEL_SCALE / static_cast<float>(fixedArea);
+
+		// NDC depth is linear in screen space
+		triangle.depth = AttributePlane<float>::Create(vOut0.position.z, vOut1.position.z, vOut2.position.z, dx1, dy1, dx2, dy2, invArea);
+
+		// When we want to interpolate vertex attributes with a correct depth(color, uv, normals, etc.),
+		// we still use the View Space depth(uses position.w)
+		const float invW0 = 1.f / vOut0.position.w;
+		const float invW1 = 1.f / vOut1.position.w;
+		const float invW2 = 1.f / vOut2.position.w;
+
+		triangle.invW = AttributePlane<float>::Create(invW0, invW1, invW2, dx1, dy1, dx2, dy2, invArea);
+		triangle.uvOverW = AttributePlane<Vector2>::Create(vOut0.uv * invW0, vOut1.uv * invW1, vOut2.uv * invW2,
+			dx1, dy1, dx2, dy2, invArea);
+		triangle.normalOverW = AttributePlane<Vector3>::Create(vOut0.normal * invW0, vOut1.normal * invW1, vOut2.normal * invW2,
+			dx1, dy1, dx2, dy2, invArea);
+		triangle.tangentOverW = AttributePlane<Vector3>::Create(vOut0.tangent * invW0, vOut1.tangent * invW1, vOut2.tangent * invW2,
+			dx1, dy1, dx2, dy2, invArea);
+		triangle.viewDirectionOverW = AttributePlane<Vector3>::Create(vOut0.viewDirection * invW0, vOut1.viewDirection * invW1, vOut2.viewDirection * invW2,
+			dx1, dy1, dx2, dy2, invArea);
+
+		// the interpolated depth can round a few ulps in front of the vertices
+		triangle.nearestDepth = std::min(std::min(vOut0.position.z, vOut1.position.z), vOut2.position.z) * (1.f - 4 * FLT_EPSILON);
+	}
+	int SoftwareRenderer::ClipPolygon(VertexOut* pPolygon, int nrOfVertices, uint8_t clipPlanes) const
+	{
+		VertexOut clipped[MAX_CLIPPED_VERTICES]{};
+
+		for (uint8_t plane{ CLIP_NEAR }; plane <= CLIP_TOP; plane <<= 1)
+		{
+			if ((clipPlanes & plane) == 0)
+				continue;
+
+			// Sutherland-Hodgman against a single plane
+			int nrOfClippedVertices{};
+			for (int i{}; i < nrOfVertices; ++i)
+			{
+				const VertexOut& current = pPolygon[i];
+				const VertexOut& next = pPolygon[(i + 1) % nrOfVertices];
+
+				const float currentDistance = GetPlaneDistance(current.position, plane);
+				const float nextDistance = GetPlaneDistance(next.position, plane);
+
+				if (currentDistance >= 0)
+					clipped[nrOfClippedVertices++] = current;
+
+				if ((currentDistance >= 0) != (nextDistance >= 0))
+					clipped[nrOfClippedVertices++] = VertexOut::Lerp(current, next, currentDistance / (currentDistance - nextDistance));
+			}
+
+			nrOfVertices = nrOfClippedVertices;
+			std::copy_n(clipped, nrOfVertices, pPolygon);
+
+			if (nrOfVertices < 3)
+				return 0;
+		}
+
+		return nrOfVertices;
+	}
+	void SoftwareRenderer::BinTriangles(const Mesh& mesh) const
+	{
+		for (int i{}; i < m_NrOfTilesX * m_NrOfTilesY; ++i)
+		{
+			m_pTiles[i].triangleIndices.clear();
+		}
+
+		for (uint32_t i{}; i < static_cast<uint32_t>(mesh.trianglesOut.size()); ++i)
+		{
+			const TriangleOut& triangle = mesh.trianglesOut[i];
+
+			const int minTileX = std::max(triangle.minX, 0) / TILE_SIZE;
+			const int minTileY = std::max(triangle.minY, 0) / TILE_SIZE;
+			const int maxTileX = std::min(triangle.maxX, m_Width - 1) / TILE_SIZE;
+			const int maxTileY = std::min(triangle.maxY, m_Height - 1) / TILE_SIZE;
+
+			for (int ty = minTileY; ty <= maxTileY; ++ty)
+			{
+				for (int tx = minTileX; tx <= maxTileX; ++tx)
+				{
+					m_pTiles[tx + ty * m_NrOfTilesX].triangleIndices.emplace_back(i);
+				}
+			}
+		}
+	}
+	void SoftwareRenderer::RasterizeTriangle(const TriangleOut& triangle, uint32_t triangleId, RasterPass pass, int clipMinX, int clipMinY, int clipMaxX, int clipMaxY) const
+	{
+		// small triangles already know which pixels they cover
+		if (triangle.maxX - triangle.minX < STAMP_SIZE && triangle.maxY - triangle.minY < STAMP_SIZE && m_BoundingBoxVisualization == false
+			&& m_UseMultisampling == false)
+		{
+			RasterizeStamp(triangle, triangleId, pass, clipMinX, clipMinY, clipMaxX, clipMaxY);
+			return;
+		}
+
+		EdgeSetup edges{};
+
+		// iterate over every pixel in the bounding box
+		edges.minX = std::max(triangle.minX, clipMinX);
+		edges.maxX = std::min(triangle.maxX + 1, clipMaxX);
+		edges.minY = std::max(triangle.minY, clipMinY);
+		edges.maxY = std::min(triangle.maxY + 1, clipMaxY);
+
+		SetupEdges(triangle, edges);
+
+		// the visualization needs the whole box, multisampling has its own traversal
+		if (m_BoundingBoxVisualization == true)
+			RasterizeBoundingBox(triangle, triangleId, pass, edges);
+		else if (m_UseMultisampling)
+			RasterizeMultisampled(triangle, triangleId, pass, edges);
+		else if (m_CurrentRasterTraversal == RasterTraversal::boundingBox)
+			RasterizeBoundingBox(triangle, triangleId, pass, edges);
+		else if (m_CurrentRasterTraversal == RasterTraversal::scanline)
+			RasterizeScanlines(triangle, triangleId, pass, edges);
+		else
+			RasterizeHierarchical(triangle, triangleId, pass, edges);
+	}
+	void SoftwareRenderer::RasterizeStamp(const TriangleOut& triangle, uint32_t triangleId, RasterPass pass, int clipMinX, int clipMinY, int clipMaxX, int clipMaxY) const
+	{
+		const INT minX = std::max(triangle.minX, clipMinX);
+		const INT maxX = std::min(triangle.maxX + 1, clipMaxX);
+		const INT minY = std::max(triangle.minY, clipMinY);
+		const INT maxY = std::min(triangle.maxY + 1, clipMaxY);
+
+		// the stamp can still straddle a few depth blocks
+		for (INT blockY = minY / DEPTH_BLOCK_SIZE; blockY <= (maxY - 1) / DEPTH_BLOCK_SIZE; ++blockY)
+		{
+			for (INT blockX = minX / DEPTH_BLOCK_SIZE; blockX <= (maxX - 1) / DEPTH_BLOCK_SIZE; ++blockX)
+			{
+				if (m_UseHierarchicalDepth && triangle.nearestDepth > m_pCoarseDepthBufferPixels[blockX + blockY * m_NrOfDepthBlocksX])
+					continue;
+
+				const INT blockMinX = std::max(blockX * DEPTH_BLOCK_SIZE, minX);
+				const INT blockMaxX = std::min((blockX + 1) * DEPTH_BLOCK_SIZE, maxX);
+				const INT blockMinY = std::max(blockY * DEPTH_BLOCK_SIZE, minY);
+				const INT blockMaxY = std::min((blockY + 1) * DEPTH_BLOCK_SIZE, maxY);
+
+				// columns of the stamp inside this block
+				const uint32_t columnMask = ((1u << (blockMaxX - triangle.minX)) - 1) & ~((1u << (blockMinX - triangle.minX)) - 1);
+
+				bool hasWrittenDepth{ false };
+
+				for (INT py = blockMinY; py < blockMaxY; ++py)
+				{
+					uint32_t coverageMask = (triangle.stampCoverage >> ((py - triangle.minY) * STAMP_SIZE)) & columnMask;
+
+					for (; coverageMask != 0; coverageMask &= coverageMask - 1)
+					{
+						hasWrittenDepth |= ShadePixel(triangle, triangleId, pass, triangle.minX + std::countr_zero(coverageMask), py, nullptr);
+					}
+				}
+
+				if (hasWrittenDepth && m_UseHierarchicalDepth)
+					UpdateCoarseDepth(blockX, blockY);
+			}
+		}
+	}
+	void SoftwareRenderer::SetupEdges(const TriangleOut& triangle, EdgeSetup& edges) const
+	{
+		// the raster positions convert to fixed point exactly
+		const int64_t fixedX[3]{
+			static_cast<int64_t>(triangle.v0.position.x * SUBPIXEL_SCALE),
+			static_cast<int64_t>(triangle.v1.position.x * SUBPIXEL_SCALE),
+			static_cast<int64_t>(triangle.v2.position.x * SUBPIXEL_SCALE) };
+		const int64_t fixedY[3]{
+			static_cast<int64_t>(triangle.v0.position.y * SUBPIXEL_SCALE),
+			static_cast<int64_t>(triangle.v1.position.y * SUBPIXEL_SCALE),
+			static_cast<int64_t>(triangle.v2.position.y * SUBPIXEL_SCALE) };
+
+		// center of the first pixel
+		const int64_t originX = (static_cast<int64_t>(edges.minX) << SUBPIXEL_BITS) + SUBPIXEL_SCALE / 2;
+		const int64_t originY = (static_cast<int64_t>(edges.minY) << SUBPIXEL_BITS) + SUBPIXEL_SCALE / 2;
+
+		for (int i{}; i < 3; ++i)
+		{
+			const int next = (i + 1) % 3;
+			const int64_t edgeX = fixedX[next] - fixedX[i];
+			const int64_t edgeY = fixedY[next] - fixedY[i];
+
+			// top-left rule: shared edges are drawn exactly once
+			const bool isTopLeftEdge = edgeY < 0 || (edgeY == 0 && edgeX > 0);
+
+			edges.origins[i] = edgeX * (originY - fixedY[i]) - edgeY * (originX - fixedX[i]) - (isTopLeftEdge ? 0 : 1);
+			edges.stepsX[i] = -edgeY * SUBPIXEL_SCALE;
+			edges.stepsY[i] = edgeX * SUBPIXEL_SCALE;
+
+			for (int lane{}; lane < COVERAGE_SPAN; ++lane)
+			{
+				edges.laneOffsets[i * COVERAGE_SPAN + lane] = lane * edges.stepsX[i];
+			}
+
+			if (m_UseMultisampling == false)
+				continue;
+
+			// whole pixel steps, exact over a sample offset as well
+			for (int lane{}; lane < COVERAGE_SPAN; ++lane)
+			{
+				const int sample = lane % MSAA_SAMPLE_COUNT;
+				edges.sampleLaneOffsets[i * COVERAGE_SPAN + lane] = (lane / MSAA_SAMPLE_COUNT) * edges.stepsX[i]
+					+ (edges.stepsX[i] / SUBPIXEL_SCALE) * MSAA_SAMPLE_OFFSETS_X[sample] + (edges.stepsY[i] / SUBPIXEL_SCALE) * MSAA_SAMPLE_OFFSETS_Y[sample];
+			}
+		}
+	}
+	uint32_t SoftwareRenderer::EvaluateStamp(const EdgeSetup& edges, int nrOfRows) const
+	{
+		// small triangles fit in 32 bit, a stamp row in one register
+		uint32_t coverage{};
+
+#if defined(__AVX2__)
+		// two rows at once
+		for (int row{}; row < nrOfRows; row += 2)
+		{
+			__m256i outside = _mm256_setzero_si256();
+			for (int i{}; i < 3; ++i)
+			{
+				const int32_t value = static_cast<int32_t>(edges.origins[i] + row * edges.stepsY[i]);
+				const int32_t stepX = static_cast<int32_t>(edges.stepsX[i]);
+				const int32_t stepY = static_cast<int32_t>(edges.stepsY[i]);
+
+				const __m256i offsets = _mm256_setr_epi32(0, stepX, 2 * stepX, 3 * stepX,
+					stepY, stepY + stepX, stepY + 2 * stepX, stepY + 3 * stepX);
+				outside = _mm256_or_si256(outside, _mm256_add_epi32(_mm256_set1_epi32(value), offsets));
+			}
+
+			coverage |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(outside)) ^ 0xFF) << (row * STAMP_SIZE);
+		}
+
+		// an odd stamp evaluated one row too many
+		coverage &= (1u << (nrOfRows * STAMP_SIZE)) - 1;
+#else
+		for (int row{}; row < nrOfRows; ++row)
+		{
+			__m128i outside = _mm_setzero_si128();
+			for (int i{}; i < 3; ++i)
+			{
+				const int32_t value = static_cast<int32_t>(edges.origins[i] + row * edges.stepsY[i]);
+				const int32_t stepX = static_cast<int32_t>(edges.stepsX[i]);
+
+				outside = _mm_or_si128(outside, _mm_add_epi32(_mm_set1_epi32(value), _mm_setr_epi32(0, stepX, 2 * stepX, 3 * stepX)));
+			}
+
+			coverage |= static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(outside)) ^ 0xF) << (row * STAMP_SIZE);
+		}
+#endif
+
+		return coverage;
+	}
+	void SoftwareRenderer::RasterizeBoundingBox(const TriangleOut& triangle, uint32_t triangleId, RasterPass pass, const EdgeSetup& edges) const
+	{
+		// block per block, so the coarse depth buffer can reject whole blocks
+		for (INT blockY = edges.minY / DEPTH_BLOCK_SIZE; blockY <= (edges.maxY - 1) / DEPTH_BLOCK_SIZE; ++blockY)
+		{
+			for (INT blockX = edges.minX / DEPTH_BLOCK_SIZE; blockX <= (edges.maxX - 1) / DEPTH_BLOCK_SIZE; ++blockX)
+			{
+				const INT blockMinX = std::max(blockX * DEPTH_BLOCK_SIZE, edges.minX);
+				const INT blockMaxX = std::min((blockX + 1) * DEPTH_BLOCK_SIZE, edges.maxX);
+				const INT blockMinY = std::max(blockY * DEPTH_BLOCK_SIZE, edges.minY);
+				const INT blockMaxY = std::min((blockY + 1) * DEPTH_BLOCK_SIZE, edges.maxY);
+
+				if (m_BoundingBoxVisualization == true)
+				{
+					for (INT py = blockMinY; py < blockMaxY; ++py)
+					{
+						for (INT px = blockMinX; px < blockMaxX; ++px)
+						{
+							WritePixel(px, py, colors::White);
+						}
+					}
+					continue;
+				}
+
+				if (m_UseHierarchicalDepth && triangle.nearestDepth > m_pCoarseDepthBufferPixels[blockX + blockY * m_NrOfDepthBlocksX])
+					continue;
+
+				const bool hasWrittenDepth = RasterizeBlock(triangle, triangleId, pass, edges, blockMinX, blockMinY, blockMaxX, blockMaxY, true);
+
+				if (hasWrittenDepth && m_UseHierarchicalDepth)
+					UpdateCoarseDepth(blockX, blockY);
+			}
+		}
+	}
+	void SoftwareRenderer::RasterizeHierarchical(const TriangleOut& triangle, uint32_t triangleId, RasterPass pass, const EdgeSetup& edges) const
+	{
+		constexpr INT subBlockSize{ DEPTH_BLOCK_SIZE / 2 };
+
+		// coarse to fine: only the blocks on an edge get split up
+		for (INT blockY = edges.minY / DEPTH_BLOCK_SIZE; blockY <= (edges.maxY - 1) / DEPTH_BLOCK_SIZE; ++blockY)
+		{
+			for (INT blockX = edges.minX / DEPTH_BLOCK_SIZE; blockX <= (edges.maxX - 1) / DEPTH_BLOCK_SIZE; ++blockX)
+			{
+				if (m_UseHierarchicalDepth && triangle.nearestDepth > m_pCoarseDepthBufferPixels[blockX + blockY * m_NrOfDepthBlocksX])
+					continue;
+
+				const INT blockMinX = std::max(blockX * DEPTH_BLOCK_SIZE, edges.minX);
+				const INT blockMaxX = std::min((blockX + 1) * DEPTH_BLOCK_SIZE, edges.maxX);
+				const INT blockMinY = std::max(blockY * DEPTH_BLOCK_SIZE, edges.minY);
+				const INT blockMaxY = std::min((blockY + 1) * DEPTH_BLOCK_SIZE, edges.maxY);
+
+				const BlockCoverage blockCoverage = ClassifyBlock(edges, blockMinX, blockMinY, blockMaxX, blockMaxY);
+
+				if (blockCoverage == BlockCoverage::outside)
+					continue;
+
+				bool hasWrittenDepth{ false };
+
+				if (blockCoverage == BlockCoverage::inside)
+				{
+					if (m_CurrentDepthFormat == DepthFormat::planeCompressed
+						&& blockMaxX - blockMinX == DEPTH_BLOCK_SIZE && blockMaxY - blockMinY == DEPTH_BLOCK_SIZE
+						&& CompressDepthBlock(triangle, triangleId, pass, blockX, blockY))
+						continue;
+
+					hasWrittenDepth = RasterizeBlock(triangle, triangleId, pass, edges, blockMinX, blockMinY, blockMaxX, blockMaxY, false);
+				}
+				else
+				{
+					for (INT subMinY = blockMinY; subMinY < blockMaxY; subMinY = (subMinY / subBlockSize + 1) * subBlockSize)
+					{
+						for (INT subMinX = blockMinX; subMinX < blockMaxX; subMinX = (subMinX / subBlockSize + 1) * subBlockSize)
+						{
+							const INT subMaxX = std::min((subMinX / subBlockSize + 1) * subBlockSize, blockMaxX);
+							const INT subMaxY = std::min((subMinY / subBlockSize + 1) * subBlockSize, blockMaxY);
+
+							const BlockCoverage subBlockCoverage = ClassifyBlock(edges, subMinX, subMinY, subMaxX, subMaxY);
+
+							if (subBlockCoverage == BlockCoverage::outside)
+								continue;
+
+							hasWrittenDepth |= RasterizeBlock(triangle, triangleId, pass, edges, subMinX, subMinY, subMaxX, subMaxY,
+								subBlockCoverage == BlockCoverage::partial);
+						}
+					}
+				}
+
+				if (hasWrittenDepth && m_UseHierarchicalDepth)
+					UpdateCoarseDepth(blockX, blockY);
+			}
+		}
+	}
+	SoftwareRenderer::BlockCoverage SoftwareRenderer::ClassifyBlock(const EdgeSetup& edges, INT minX, INT minY, INT maxX, INT maxY) const
+	{
+		bool isInside{ true };
+
+		for (int i{}; i < 3; ++i)
+		{
+			// the edge functions are linear, their extremes lie in the corners
+			const int64_t value = edges.origins[i] + (minX - edges.minX) * edges.stepsX[i] + (minY - edges.minY) * edges.stepsY[i];
+			const int64_t deltaX = (maxX - 1 - minX) * edges.stepsX[i];
+			const int64_t deltaY = (maxY - 1 - minY) * edges.stepsY[i];
+
+			if (value + std::max<int64_t>(deltaX, 0) + std::max<int64_t>(deltaY, 0) < 0)
+				return BlockCoverage::outside;
+
+			if (value + std::min<int64_t>(deltaX, 0) + std::min<int64_t>(deltaY, 0) < 0)
+				isInside = false;
+		}
+
+		return isInside ? BlockCoverage::inside : BlockCoverage::partial;
+	}
+	bool SoftwareRenderer::RasterizeBlock(const TriangleOut& triangle, uint32_t triangleId, RasterPass pass, const EdgeSetup& edges,
+		INT minX, INT minY, INT maxX, INT maxY, bool testCoverage) const
+	{
+		bool hasWrittenDepth{ false };
+
+		for (INT py = minY; py < maxY; ++py)
+		{
+			if (testCoverage == false)
+			{
+				for (INT px = minX; px < maxX; ++px)
+				{
+					hasWrittenDepth |= ShadePixel(triangle, triangleId, pass, px, py, nullptr);
+				}
+				continue;
+			}
+
+			int64_t edgeValues[3];
+			for (int i{}; i < 3; ++i)
+			{
+				edgeValues[i] = edges.origins[i] + (minX - edges.minX) * edges.stepsX[i] + (py - edges.minY) * edges.stepsY[i];
+			}
+
+			for (INT px = minX; px < maxX; px += COVERAGE_SPAN)
+			{
+				uint32_t coverageMask{ (1u << COVERAGE_SPAN) - 1 };
+				if (maxX - px < COVERAGE_SPAN)
+					coverageMask = (1u << (maxX - px)) - 1;
+
+				coverageMask &= EvaluateEdgeFunctions(edgeValues, edges.laneOffsets);
+
+				for (int i{}; i < 3; ++i)
+				{
+					edgeValues[i] += COVERAGE_SPAN * edges.stepsX[i];
+				}
+
+				// depth test and shading only for the covered pixels
+				for (; coverageMask != 0; coverageMask &= coverageMask - 1)
+				{
+					hasWrittenDepth |= ShadePixel(triangle, triangleId, pass, px + std::countr_zero(coverageMask), py, nullptr);
+				}
+			}
+		}
+
+		return hasWrittenDepth;
+	}
+	void SoftwareRenderer::RasterizeScanlines(const TriangleOut& triangle, uint32_t triangleId, RasterPass pass, const EdgeSetup& edges) const
+	{
+		// only step the attributes when they get shaded right away
+		const bool stepsInterpolants = pass != RasterPass::depthOnly && m_CurrentRenderPath != RenderPath::visibilityBuffer;
+
+		// edge functions at the first pixel of the current row
+		int64_t rowValues[3]{ edges.origins[0], edges.origins[1], edges.origins[2] };
+
+		// range of depth blocks written in the current row of blocks
+		INT dirtyMinBlockX{ INT_MAX };
+		INT dirtyMaxBlockX{ INT_MIN };
+
+		for (INT py = edges.minY; py < edges.maxY; ++py)
+		{
+			// every edge bounds the span of covered pixels from one side
+			INT left = edges.minX;
+			INT right = edges.maxX - 1;
+
+			for (int i{}; i < 3; ++i)
+			{
+				const int64_t stepX = edges.stepsX[i];
+
+				if (stepX > 0)
+				{
+					// rowValue + k * stepX >= 0
+					if (rowValues[i] < 0)
+						left = static_cast<INT>(std::max<int64_t>(left, edges.minX + (-rowValues[i] + stepX - 1) / stepX));
+				}
+				else if (stepX < 0)
+				{
+					if (rowValues[i] < 0)
+						right = edges.minX - 1;
+					else
+						right = static_cast<INT>(std::min<int64_t>(right, edges.minX + rowValues[i] / -stepX));
+				}
+				else if (rowValues[i] < 0)
+				{
+					right = edges.minX - 1;
+				}
+
+				rowValues[i] += edges.stepsY[i];
+			}
+
+			const INT blockY = py / DEPTH_BLOCK_SIZE;
+
+			// split per depth block, so the coarse depth buffer can reject parts
+			for (INT segmentMinX = left; segmentMinX <= right; segmentMinX = (segmentMinX / DEPTH_BLOCK_SIZE + 1) * DEPTH_BLOCK_SIZE)
+			{
+				const INT blockX = segmentMinX / DEPTH_BLOCK_SIZE;
+				const INT segmentMaxX = std::min(right, (blockX + 1) * DEPTH_BLOCK_SIZE - 1);
+
+				if (m_UseHierarchicalDepth && triangle.nearestDepth > m_pCoarseDepthBufferPixels[blockX + blockY * m_NrOfDepthBlocksX])
+					continue;
+
+				// evaluated again per block, so the rounding of the steps can not build up
+				PixelInterpolants interpolants{};
+				if (stepsInterpolants)
+					interpolants = triangle.EvaluateInterpolants((segmentMinX + 0.5f) - triangle.v0.position.x, (py + 0.5f) - triangle.v0.position.y);
+
+				bool hasWrittenDepth{ false };
+
+				for (INT px = segmentMinX; px <= segmentMaxX; ++px)
+				{
+					hasWrittenDepth |= ShadePixel(triangle, triangleId, pass, px, py, stepsInterpolants ? &interpolants : nullptr);
+
+					if (stepsInterpolants)
+						triangle.StepInterpolantsX(interpolants);
+				}
+
+				if (hasWrittenDepth)
+				{
+					dirtyMinBlockX = std::min(dirtyMinBlockX, blockX);
+					dirtyMaxBlockX = std::max(dirtyMaxBlockX, blockX);
+				}
+			}
+
+			// the coarse depth is updated once all rows in the block are done
+			if (m_UseHierarchicalDepth && (py + 1 == edges.maxY || (py + 1) % DEPTH_BLOCK_SIZE == 0))
+			{
+				for (INT blockX = dirtyMinBlockX; blockX <= dirtyMaxBlockX; ++blockX)
+				{
+					UpdateCoarseDepth(blockX, blockY);
+				}
+
+				dirtyMinBlockX = INT_MAX;
+				dirtyMaxBlockX = INT_MIN;
+			}
+		}
+	}
+	void SoftwareRenderer::RasterizeMultisampled(const TriangleOut& triangle, uint32_t triangleId, RasterPass pass, const EdgeSetup& edges) const
+	{
+		for (INT blockY = edges.minY / DEPTH_BLOCK_SIZE; blockY <= (edges.maxY - 1) / DEPTH_BLOCK_SIZE; ++blockY)
+		{
+			for (INT blockX = edges.minX / DEPTH_BLOCK_SIZE; blockX <= (edges.maxX - 1) / DEPTH_BLOCK_SIZE; ++blockX)
+			{
+				if (m_UseHierarchicalDepth && triangle.nearestDepth > m_pCoarseDepthBufferPixels[blockX + blockY * m_NrOfDepthBlocksX])
+					continue;
+
+				const INT blockMinX = std::max(blockX * DEPTH_BLOCK_SIZE, edges.minX);
+				const INT blockMaxX = std::min((blockX + 1) * DEPTH_BLOCK_SIZE, edges.maxX);
+				const INT blockMinY = std::max(blockY * DEPTH_BLOCK_SIZE, edges.minY);
+				const INT blockMaxY = std::min((blockY + 1) * DEPTH_BLOCK_SIZE, edges.maxY);
+
+				// the pixel centers of the block grown by one pixel enclose all of its samples
+				const BlockCoverage blockCoverage = ClassifyBlock(edges, blockMinX - 1, blockMinY - 1, blockMaxX + 1, blockMaxY + 1);
+
+				if (blockCoverage == BlockCoverage::outside)
+					continue;
+
+				const bool hasWrittenDepth = RasterizeSampleBlock(triangle, triangleId, pass, edges, blockMinX, blockMinY, blockMaxX, blockMaxY,
+					blockCoverage == BlockCoverage::partial);
+
+				if (hasWrittenDepth && m_UseHierarchicalDepth)
+					UpdateCoarseDepth(blockX, blockY);
+			}
+		}
+	}
+	bool SoftwareRenderer::RasterizeSampleBlock(const TriangleOut& triangle, uint32_t triangleId, RasterPass pass, const EdgeSetup& edges,
+		INT minX, INT minY, INT maxX, INT maxY, bool testCoverage) const
+	{
+		constexpr INT pixelsPerSpan{ COVERAGE_SPAN / MSAA_SAMPLE_COUNT };
+
+		bool hasWrittenDepth{ false };
+
+		for (INT py = minY; py < maxY; ++py)
+		{
+			if (testCoverage == false)
+			{
+				for (INT px = minX; px < maxX; ++px)
+				{
+					hasWrittenDepth |= ShadeSamples(triangle, triangleId, pass, px, py, MSAA_ALL_SAMPLES);
+				}
+				continue;
+			}
+
+			int64_t edgeValues[3];
+			for (int i{}; i < 3; ++i)
+			{
+				edgeValues[i] = edges.origins[i] + (minX - edges.minX) * edges.stepsX[i] + (py - edges.minY) * edges.stepsY[i];
+			}
+
+			for (INT px = minX; px < maxX; px += pixelsPerSpan)
+			{
+				uint32_t coverageMask = EvaluateEdgeFunctions(edgeValues, edges.sampleLaneOffsets);
+
+				for (int i{}; i < 3; ++i)
+				{
+					edgeValues[i] += pixelsPerSpan * edges.stepsX[i];
+				}
+
+				for (INT pixel{}; pixel < pixelsPerSpan && px + pixel < maxX; ++pixel)
+				{
+					const uint32_t sampleMask = (coverageMask >> (pixel * MSAA_SAMPLE_COUNT)) & MSAA_ALL_SAMPLES;
+					if (sampleMask != 0)
+						hasWrittenDepth |= ShadeSamples(triangle, triangleId, pass, px + pixel, py, sampleMask);
+				}
+			}
+		}
+
+		return hasWrittenDepth;
+	}
+	void SoftwareRenderer::UpdateCoarseDepth(INT blockX, INT blockY) const
+	{
+		const INT minX = blockX * DEPTH_BLOCK_SIZE;
+		const INT minY = blockY * DEPTH_BLOCK_SIZE;
+		const INT maxX = std::min(minX + DEPTH_BLOCK_SIZE, m_Width);
+		const INT maxY = std::min(minY + DEPTH_BLOCK_SIZE, m_Height);
+
+		// with multisampling every sample counts
+		const INT nrOfSamples = GetNrOfSamples();
+
+		float maxDepth{};
+
+		if (m_CurrentDepthFormat == DepthFormat::unorm24 || m_CurrentDepthFormat == DepthFormat::unorm16 || maxX - minX != DEPTH_BLOCK_SIZE)
+		{
+			// the codes are ordered like the depths they hold
+			uint32_t maxDepthCode{};
+			for (INT py = minY; py < maxY; ++py)
+			{
+				const INT firstSampleIdx = GetPixelIndex(minX, py) * nrOfSamples;
+				for (INT sampleIdx = firstSampleIdx; sampleIdx < firstSampleIdx + (maxX - minX) * nrOfSamples; ++sampleIdx)
+				{
+					maxDepthCode = std::max(maxDepthCode, ReadDepthCode(sampleIdx));
+				}
+			}
+
+			maxDepth = DecodeDepth(maxDepthCode);
+		}
+		else
+		{
+			const float* pDepths = reinterpret_cast<const float*>(m_pDepthBuffer);
+
+			// a row of a block is contiguous in both layouts
+			__m128 maxDepths = _mm_setzero_ps();
+			for (INT py = minY; py < maxY; ++py)
+			{
+				const float* pRow = &pDepths[GetPixelIndex(minX, py) * nrOfSamples];
+				for (INT i{}; i < DEPTH_BLOCK_SIZE * nrOfSamples; i += 8)
+				{
+					maxDepths = _mm_max_ps(maxDepths, _mm_max_ps(_mm_loadu_ps(pRow + i), _mm_loadu_ps(pRow + i + 4)));
+				}
+			}
+
+			float lanes[4];
+			_mm_storeu_ps(lanes, maxDepths);
+			maxDepth = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+		}
+
+		m_pCoarseDepthBufferPixels[blockX + blockY * m_NrOfDepthBlocksX] = maxDepth;
+	}
+	uint32_t SoftwareRenderer::EncodeDepth(float depth) const
+	{
+		// rounded up so the code never lies in front of the depth, exact in a double
+		switch (m_CurrentDepthFormat)
+		{
+		case DepthFormat::unorm24:
+			return static_cast<uint32_t>(std::ceil(static_cast<double>(depth) * DEPTH_UNORM24_MAX));
+		case DepthFormat::unorm16:
+			return static_cast<uint32_t>(std::ceil(static_cast<double>(depth) * DEPTH_UNORM16_MAX));
+		default:
+			// positive floats are ordered like their bits, adding zero turns -0 into +0
+			return std::bit_cast<uint32_t>(depth + 0.f);
+		}
+	}
+	float SoftwareRenderer::DecodeDepth(uint32_t depthCode) const
+	{
+		// rounded up, the coarse depth stays behind every pixel
+		switch (m_CurrentDepthFormat)
+		{
+		case DepthFormat::unorm24:
+			return std::nextafter(static_cast<float>(depthCode / static_cast<double>(DEPTH_UNORM24_MAX)), FLT_MAX);
+		case DepthFormat::unorm16:
+			return std::nextafter(static_cast<float>(depthCode / static_cast<double>(DEPTH_UNORM16_MAX)), FLT_MAX);
+		default:
+			return std::bit_cast<float>(depthCode);
+		}
+	}
+	uint32_t SoftwareRenderer::ReadDepthCode(INT pixelIdx) const
+	{
+		switch (m_CurrentDepthFormat)
+		{
+		case DepthFormat::unorm24:
+		{
+			// byte by byte, the neighbouring pixel can belong to another thread
+			const uint8_t* pPixel = m_pDepthBuffer + pixelIdx * 3;
+			return pPixel[0] | (pPixel[1] << 8) | (pPixel[2] << 16);
+		}
+		case DepthFormat::unorm16:
+			return reinterpret_cast<const uint16_t*>(m_pDepthBuffer)[pixelIdx];
+		default:
+			return reinterpret_cast<const uint32_t*>(m_pDepthBuffer)[pixelIdx];
+		}
+	}
+	void SoftwareRenderer::WriteDepthCode(INT pixelIdx, uint32_t depthCode) const
+	{
+		switch (m_CurrentDepthFormat)
+		{
+		case DepthFormat::unorm24:
+		{
+			uint8_t* pPixel = m_pDepthBuffer + pixelIdx * 3;
+			pPixel[0] = static_cast<uint8_t>(depthCode);
+			pPixel[1] = static_cast<uint8_t>(depthCode >> 8);
+			pPixel[2] = static_cast<uint8_t>(depthCode >> 16);
+			break;
+		}
+		case DepthFormat::unorm16:
+			reinterpret_cast<uint16_t*>(m_pDepthBuffer)[pixelIdx] = static_cast<uint16_t>(depthCode);
+			break;
+		default:
+			reinterpret_cast<uint32_t*>(m_pDepthBuffer)[pixelIdx] = depthCode;
+			break;
+		}
+	}
+	float SoftwareRenderer::ReadDepth(INT px, INT py) const
+	{
+		// compressed blocks are read from their plane, safe from several threads
+		if (m_CurrentDepthFormat == DepthFormat::planeCompressed)
+		{
+			const INT blockIdx = px / DEPTH_BLOCK_SIZE + (py / DEPTH_BLOCK_SIZE) * m_NrOfDepthBlocksX;
+			switch (m_pDepthBlockStates[blockIdx])
+			{
+			case DepthBlockState::cleared:
+				return FLT_MAX;
+			case DepthBlockState::plane:
+			{
+				const TriangleOut& triangle = *m_pDepthBlockPlanes[blockIdx];
+				return triangle.depth.Evaluate((px + 0.5f) - triangle.v0.position.x, (py + 0.5f) - triangle.v0.position.y);
+			}
+			default:
+				break;
+			}
+		}
+
+		return DecodeDepth(ReadDepthCode(GetPixelIndex(px, py)));
+	}
+	void SoftwareRenderer::ClearDepth(INT firstPixelIdx, INT nrOfPixels) const
+	{
+		// the cleared code is the largest one of the format
+		switch (m_CurrentDepthFormat)
+		{
+		case DepthFormat::unorm24:
+			std::fill_n(m_pDepthBuffer + firstPixelIdx * 3, nrOfPixels * 3, uint8_t{ 0xFF });
+			break;
+		case DepthFormat::unorm16:
+			std::fill_n(reinterpret_cast<uint16_t*>(m_pDepthBuffer) + firstPixelIdx, nrOfPixels, uint16_t{ 0xFFFF });
+			break;
+		default:
+			std::fill_n(reinterpret_cast<float*>(m_pDepthBuffer) + firstPixelIdx, nrOfPixels, FLT_MAX);
+			break;
+		}
+	}
+	bool SoftwareRenderer::IsDepthQuantized() const
+	{
+		return m_CurrentDepthFormat == DepthFormat::unorm24 || m_CurrentDepthFormat == DepthFormat::unorm16;
+	}
+	bool SoftwareRenderer::CompressDepthBlock(const TriangleOut& triangle, uint32_t triangleId, RasterPass pass, INT blockX, INT blockY) const
+	{
+		const INT blockIdx = blockX + blockY * m_NrOfDepthBlocksX;
+		const INT minX = blockX * DEPTH_BLOCK_SIZE;
+		const INT minY = blockY * DEPTH_BLOCK_SIZE;
+
+		if (pass == RasterPass::equalDepthColor)
+		{
+			// compressed with this triangle in the prepass, nothing to compare
+			if (m_pDepthBlockStates[blockIdx] != DepthBlockState::plane || m_pDepthBlockPlanes[blockIdx] != &triangle)
+				return false;
+		}
+		else
+		{
+			// only an empty block ends up with nothing but this triangle
+			if (m_pDepthBlockStates[blockIdx] != DepthBlockState::cleared)
+				return false;
+
+			// the plane is linear, its extremes lie in the corners
+			constexpr float lastPixelOffset{ DEPTH_BLOCK_SIZE - 1.f };
+			const float dx = (minX + 0.5f) - triangle.v0.position.x;
+			const float dy = (minY + 0.5f) - triangle.v0.position.y;
+			const float cornerDepths[4]{
+				triangle.depth.Evaluate(dx, dy),
+				triangle.depth.Evaluate(dx + lastPixelOffset, dy),
+				triangle.depth.Evaluate(dx, dy + lastPixelOffset),
+				triangle.depth.Evaluate(dx + lastPixelOffset, dy + lastPixelOffset) };
+
+			const auto [minDepth, maxDepth] = std::minmax({ cornerDepths[0], cornerDepths[1], cornerDepths[2], cornerDepths[3] });
+			if (minDepth < DEPTH_PLANE_MARGIN || maxDepth > 1.f - DEPTH_PLANE_MARGIN)
+				return false;
+
+			m_pDepthBlockStates[blockIdx] = DepthBlockState::plane;
+			m_pDepthBlockPlanes[blockIdx] = &triangle;
+			m_pCoarseDepthBufferPixels[blockIdx] = maxDepth + DEPTH_PLANE_MARGIN;
+
+			if (pass == RasterPass::depthOnly)
+				return true;
+		}
+
+		for (INT py = minY; py < minY + DEPTH_BLOCK_SIZE; ++py)
+		{
+			for (INT px = minX; px < minX + DEPTH_BLOCK_SIZE; ++px)
+			{
+				if (m_CurrentRenderPath == RenderPath::visibilityBuffer && pass == RasterPass::depthAndColor)
+				{
+					m_pVisibilityBuffer[GetPixelIndex(px, py)] = triangleId;
+					continue;
+				}
+
+				if (const int shadingRate = GetShadingRate(px, py); shadingRate > 1)
+				{
+					WritePixel(px, py, ShadeCell(triangle, triangleId, px, py, shadingRate));
+					continue;
+				}
+
+				const float dx = (px + 0.5f) - triangle.v0.position.x;
+				const float dy = (py + 0.5f) - triangle.v0.position.y;
+				WritePixel(px, py, ShadeFragment(triangle.EvaluateInterpolants(dx, dy), px, py, triangle.depth.Evaluate(dx, dy)));
+			}
+		}
+
+		return true;
+	}
+	void SoftwareRenderer::DecompressDepthBlock(INT blockX, INT blockY) const
+	{
+		const INT blockIdx = blockX + blockY * m_NrOfDepthBlocksX;
+		const INT minX = blockX * DEPTH_BLOCK_SIZE;
+		const INT minY = blockY * DEPTH_BLOCK_SIZE;
+		const INT maxX = std::min(minX + DEPTH_BLOCK_SIZE, m_Width);
+		const INT maxY = std::min(minY + DEPTH_BLOCK_SIZE, m_Height);
+
+		const INT nrOfSamples = GetNrOfSamples();
+
+		for (INT py = minY; py < maxY; ++py)
+		{
+			if (m_pDepthBlockStates[blockIdx] == DepthBlockState::cleared)
+			{
+				ClearDepth(GetPixelIndex(minX, py) * nrOfSamples, (maxX - minX) * nrOfSamples);
+				continue;
+			}
+
+			// evaluated like ShadePixel, so the prepass finds the same depths
+			const TriangleOut& triangle = *m_pDepthBlockPlanes[blockIdx];
+			for (INT px = minX; px < maxX; ++px)
+			{
+				const float dx = (px + 0.5f) - triangle.v0.position.x;
+				const float dy = (py + 0.5f) - triangle.v0.position.y;
+
+				if (m_UseMultisampling == false)
+				{
+					WriteDepthCode(GetPixelIndex(px, py), EncodeDepth(triangle.depth.Evaluate(dx, dy)));
+					continue;
+				}
+
+				for (int sample{}; sample < MSAA_SAMPLE_COUNT; ++sample)
+				{
+					const float depth = triangle.depth.Evaluate(dx + MSAA_SAMPLE_OFFSETS_X[sample] / static_cast<float>(SUBPIXEL_SCALE),
+						dy + MSAA_SAMPLE_OFFSETS_Y[sample] / static_cast<float>(SUBPIXEL_SCALE));
+					WriteDepthCode(GetPixelIndex(px, py) * MSAA_SAMPLE_COUNT + sample, EncodeDepth(depth));
+				}
+			}
+		}
+
+		m_pDepthBlockStates[blockIdx] = DepthBlockState::pixels;
+	}
+	uint32_t SoftwareRenderer::EvaluateEdgeFunctions(const int64_t* pEdgeValues, const int64_t* pLaneOffsets) const
+	{
+		// the OR of the edge functions keeps the sign bit of every uncovered pixel
+#if defined(__AVX2__)
+		__m256i lanes0123 = _mm256_setzero_si256();
+		__m256i lanes4567 = _mm256_setzero_si256();
+		for (int i{}; i < 3; ++i)
+		{
+			const __m256i edgeValue = _mm256_set1_epi64x(pEdgeValues[i]);
+			const __m256i* pOffsets = reinterpret_cast<const __m256i*>(&pLaneOffsets[i * COVERAGE_SPAN]);
+
+			lanes0123 = _mm256_or_si256(lanes0123, _mm256_add_epi64(edgeValue, _mm256_loadu_si256(pOffsets)));
+			lanes4567 = _mm256_or_si256(lanes4567, _mm256_add_epi64(edgeValue, _mm256_loadu_si256(pOffsets + 1)));
+		}
+
+		const uint32_t outside = _mm256_movemask_pd(_mm256_castsi256_pd(lanes0123))
+			| (_mm256_movemask_pd(_mm256_castsi256_pd(lanes4567)) << 4);
+#else
+		__m128i lanes01 = _mm_setzero_si128();
+		__m128i lanes23 = _mm_setzero_si128();
+		for (int i{}; i < 3; ++i)
+		{
+			const __m128i edgeValue = _mm_set1_epi64x(pEdgeValues[i]);
+			const __m128i* pOffsets = reinterpret_cast<const __m128i*>(&pLaneOffsets[i * COVERAGE_SPAN]);
+
+			lanes01 = _mm_or_si128(lanes01, _mm_add_epi64(edgeValue, _mm_loadu_si128(pOffsets)));
+			lanes23 = _mm_or_si128(lanes23, _mm_add_epi64(edgeValue, _mm_loadu_si128(pOffsets + 1)));
+		}
+
+		const uint32_t outside = _mm_movemask_pd(_mm_castsi128_pd(lanes01))
+			| (_mm_movemask_pd(_mm_castsi128_pd(lanes23)) << 2);
+#endif
+
+		return ~outside & ((1u << COVERAGE_SPAN) - 1);
+	}
+	bool SoftwareRenderer::ShadePixel(const TriangleOut& triangle, uint32_t triangleId, RasterPass pass, INT px, INT py, const PixelInterpolants* pInterpolants) const
+	{
+		const float dx = (px + 0.5f) - triangle.v0.position.x;
+		const float dy = (py + 0.5f) - triangle.v0.position.y;
+
+		// This Z-BufferValue is the one we compare in the Depth Test and
+		// the value we store in the Depth Buffer (uses position.z).
+		// always from the plane, every traversal writes the same depth
+		const float interpolatedZDepth = triangle.depth.Evaluate(dx, dy);
+
+		if (interpolatedZDepth < 0 || interpolatedZDepth > 1)
+			return false;
+
+		if (m_CurrentDepthFormat == DepthFormat::planeCompressed
+			&& m_pDepthBlockStates[px / DEPTH_BLOCK_SIZE + (py / DEPTH_BLOCK_SIZE) * m_NrOfDepthBlocksX] != DepthBlockState::pixels)
+			DecompressDepthBlock(px / DEPTH_BLOCK_SIZE, py / DEPTH_BLOCK_SIZE);
+
+		const uint32_t depthCode = EncodeDepth(interpolatedZDepth);
+		const INT pixelIdx = GetPixelIndex(px, py);
+
+		if (pass == RasterPass::equalDepthColor)
+		{
+			// the depth prepass already picked the visible fragment, the planes match exactly
+			if (depthCode != ReadDepthCode(pixelIdx))
+				return false;
+
+			// the unorm formats round nearby fragments together, the pixel belongs to its last writer
+			if (IsDepthQuantized() && m_pVisibilityBuffer[pixelIdx] != triangleId)
+				return false;
+
+			if (const int shadingRate = GetShadingRate(px, py); shadingRate > 1)
+				WritePixel(px, py, ShadeCell(triangle, triangleId, px, py, shadingRate));
+			else
+				WritePixel(px, py, ShadeFragment(pInterpolants ? *pInterpolants : triangle.EvaluateInterpolants(dx, dy), px, py, interpolatedZDepth));
+			return false;
+		}
+
+		if (depthCode > ReadDepthCode(pixelIdx))
+			return false;
+
+		WriteDepthCode(pixelIdx, depthCode);
+
+		if (pass == RasterPass::depthOnly)
+		{
+			if (IsDepthQuantized())
+				m_pVisibilityBuffer[pixelIdx] = triangleId;
+			return true;
+		}
+
+		if (m_CurrentRenderPath == RenderPath::visibilityBuffer)
+		{
+			m_pVisibilityBuffer[pixelIdx] = triangleId;
+			return true;
+		}
+
+		if (const int shadingRate = GetShadingRate(px, py); shadingRate > 1)
+			WritePixel(px, py, ShadeCell(triangle, triangleId, px, py, shadingRate));
+		else
+			WritePixel(px, py, ShadeFragment(pInterpolants ? *pInterpolants : triangle.EvaluateInterpolants(dx, dy), px, py, interpolatedZDepth));
+		return true;
+	}
+	bool SoftwareRenderer::ShadeSamples(const TriangleOut& triangle, uint32_t triangleId, RasterPass pass, INT px, INT py, uint32_t sampleMask) const
+	{
+		const float dx = (px + 0.5f) - triangle.v0.position.x;
+		const float dy = (py + 0.5f) - triangle.v0.position.y;
+		const INT firstSampleIdx = GetPixelIndex(px, py) * MSAA_SAMPLE_COUNT;
+
+		if (m_CurrentDepthFormat == DepthFormat::planeCompressed
+			&& m_pDepthBlockStates[px / DEPTH_BLOCK_SIZE + (py / DEPTH_BLOCK_SIZE) * m_NrOfDepthBlocksX] != DepthBlockState::pixels)
+			DecompressDepthBlock(px / DEPTH_BLOCK_SIZE, py / DEPTH_BLOCK_SIZE);
+
+		// every covered sample gets its own depth test
+		uint32_t passedMask{};
+		for (uint32_t mask = sampleMask; mask != 0; mask &= mask - 1)
+		{
+			const int sample = std::countr_zero(mask);
+			const float depth = triangle.depth.Evaluate(dx + MSAA_SAMPLE_OFFSETS_X[sample] / static_cast<float>(SUBPIXEL_SCALE),
+				dy + MSAA_SAMPLE_OFFSETS_Y[sample] / static_cast<float>(SUBPIXEL_SCALE));
+
+			if (depth < 0 || depth > 1)
+				continue;
+
+			const uint32_t depthCode = EncodeDepth(depth);
+
+			if (pass == RasterPass::equalDepthColor)
+			{
+				if (depthCode == ReadDepthCode(firstSampleIdx + sample)
+					&& (IsDepthQuantized() == false || m_pVisibilityBuffer[firstSampleIdx + sample] == triangleId))
+					passedMask |= 1u << sample;
+				continue;
+			}
+
+			if (depthCode > ReadDepthCode(firstSampleIdx + sample))
+				continue;
+
+			WriteDepthCode(firstSampleIdx + sample, depthCode);
+			if (pass == RasterPass::depthOnly && IsDepthQuantized())
+				m_pVisibilityBuffer[firstSampleIdx + sample] = triangleId;
+			passedMask |= 1u << sample;
+		}
+
+		if (passedMask == 0)
+			return false;
+
+		if (pass == RasterPass::depthOnly)
+			return true;
+
+		if (m_CurrentRenderPath == RenderPath::visibilityBuffer)
+		{
+			for (uint32_t mask = passedMask; mask != 0; mask &= mask - 1)
+			{
+				m_pVisibilityBuffer[firstSampleIdx + std::countr_zero(mask)] = triangleId;
+			}
+			return true;
+		}
+
+		if (const int shadingRate = GetShadingRate(px, py); shadingRate > 1)
+		{
+			WriteSamples(px, py, ShadeCell(triangle, triangleId, px, py, shadingRate), passedMask);
+			return pass != RasterPass::equalDepthColor;
+		}
+
+		// shaded once, at the center or the first passed sample, never past the edge
+		float shadeDx{ dx };
+		float shadeDy{ dy };
+		if (passedMask != MSAA_ALL_SAMPLES)
+		{
+			shadeDx += MSAA_SAMPLE_OFFSETS_X[std::countr_zero(passedMask)] / static_cast<float>(SUBPIXEL_SCALE);
+			shadeDy += MSAA_SAMPLE_OFFSETS_Y[std::countr_zero(passedMask)] / static_cast<float>(SUBPIXEL_SCALE);
+		}
+
+		WriteSamples(px, py, ShadeFragment(triangle.EvaluateInterpolants(shadeDx, shadeDy), px, py, triangle.depth.Evaluate(shadeDx, shadeDy)), passedMask);
+		return pass != RasterPass::equalDepthColor;
+	}
+	ColorRGB SoftwareRenderer::ShadeFragment(const PixelInterpolants& interpolants, INT px, INT py, float depth) const
+	{
+		ColorRGB finalColor{ colors::Black };
+
+		if (m_DepthBufferVisualization == false)
+		{
+			const float interpolatedWDepth = 1.f / interpolants.invW;
+
+			//Interpolated Vertex Attributes for Pixel
+			VertexOut pixel;
+			pixel.position = { (float)px, (float)py, depth, interpolatedWDepth };
+			pixel.color = finalColor;
+			pixel.uv = interpolants.uvOverW * interpolatedWDepth;
+			pixel.normal = interpolants.normalOverW * interpolatedWDepth;
+			pixel.tangent = interpolants.tangentOverW * interpolatedWDepth;
+			pixel.viewDirection = interpolants.viewDirectionOverW * interpolatedWDepth;
+
+			PixelShading(pixel);
+
+			finalColor = pixel.color;
+		}
+		else
+		{
+			const float depthBufferColor = Remap(depth, 0.995f, 1.0f);
+
+			finalColor = { depthBufferColor, depthBufferColor, depthBufferColor };
+		}
+
+		return finalColor;
+	}
+	int SoftwareRenderer::GetShadingRate(INT px, INT py) const
+	{
+		// the depth visualization has nothing to shade
+		if (m_DepthBufferVisualization)
+			return 1;
+
+		switch (m_CurrentShadingRate)
+		{
+		case ShadingRate::rate2x2:
+			return 2;
+		case ShadingRate::rate4x4:
+			return 4;
+		case ShadingRate::adaptive:
+			return m_pTiles[px / TILE_SIZE + (py / TILE_SIZE) * m_NrOfTilesX].shadingRate;
+		default:
+			return 1;
+		}
+	}
+	ColorRGB SoftwareRenderer::ShadeCell(const TriangleOut& triangle, uint32_t triangleId, INT px, INT py, int shadingRate) const
+	{
+		const INT cellIdx = (px / DEPTH_BLOCK_SIZE + (py / DEPTH_BLOCK_SIZE) * m_NrOfDepthBlocksX) * SHADING_CELLS_PER_BLOCK
+			+ (py % DEPTH_BLOCK_SIZE) / shadingRate * (DEPTH_BLOCK_SIZE / shadingRate) + (px % DEPTH_BLOCK_SIZE) / shadingRate;
+
+		// an earlier pixel of the cell already shaded this triangle
+		if (m_pShadingCellTriangles[cellIdx] == triangleId)
+			return m_pShadingCellColors[cellIdx];
+
+		// shaded at the cell center, clamped onto the triangle (the textures are not wrapped)
+		const Vector2 shadingPoint = triangle.ClampInside((px - px % shadingRate) + shadingRate * 0.5f, (py - py % shadingRate) + shadingRate * 0.5f);
+
+		const float dx = shadingPoint.x - triangle.v0.position.x;
+		const float dy = shadingPoint.y - triangle.v0.position.y;
+		const ColorRGB color = ShadeFragment(triangle.EvaluateInterpolants(dx, dy), px, py, triangle.depth.Evaluate(dx, dy));
+
+		m_pShadingCellTriangles[cellIdx] = triangleId;
+		m_pShadingCellColors[cellIdx] = color;
+		return color;
+	}
+	void SoftwareRenderer::UpdateShadingRates() const
+	{
+		// pick the shading rate of every tile for the next frame
+		const auto getLuminance = [this](INT px, INT py)
+			{
+				const uint32_t pixel = m_pBackBufferPixels[px + py * m_Width];
+				return static_cast<int>((77 * ((pixel >> m_RedShift) & 0xFF) + 150 * ((pixel >> m_GreenShift) & 0xFF) + 29 * ((pixel >> m_BlueShift) & 0xFF)) >> 8);
+			};
+
+		m_pThreadPool->ParallelFor(static_cast<uint32_t>(m_NrOfTilesX * m_NrOfTilesY), [&](uint32_t tileIdx)
+			{
+				Tile& tile = m_pTiles[tileIdx];
+
+				int gradientSum{};
+				int nrOfProbes{};
+				for (INT py = tile.minY; py + SHADING_RATE_PROBE_DISTANCE < tile.maxY; py += SHADING_RATE_PROBE_DISTANCE)
+				{
+					for (INT px = tile.minX; px + SHADING_RATE_PROBE_DISTANCE < tile.maxX; px += SHADING_RATE_PROBE_DISTANCE)
+					{
+						const int luminance = getLuminance(px, py);
+						gradientSum += std::abs(getLuminance(px + SHADING_RATE_PROBE_DISTANCE, py) - luminance)
+							+ std::abs(getLuminance(px, py + SHADING_RATE_PROBE_DISTANCE) - luminance);
+						++nrOfProbes;
+					}
+				}
+
+				const float gradient = nrOfProbes > 0 ? gradientSum / static_cast<float>(nrOfProbes * SHADING_RATE_PROBE_DISTANCE) : 0.f;
+
+				if (gradient < SHADING_RATE_4X4_GRADIENT)
+					tile.shadingRate = 4;
+				else if (gradient < SHADING_RATE_2X2_GRADIENT)
+					tile.shadingRate = 2;
+				else
+					tile.shadingRate = 1;
+			});
+	}
+	void SoftwareRenderer::ResolveVisibilityBuffer() const
+	{
+		std::vector<const Mesh*> meshes{};
+		for (const auto& mesh : *m_pMeshToShadedEffectMap | std::views::keys)
+		{
+			meshes.emplace_back(mesh);
+		}
+
+		// find the mesh the triangle belongs to
+		const auto getTriangle = [&meshes](uint32_t triangleIdx) -> const TriangleOut&
+			{
+				auto meshIt = meshes.begin();
+				while (triangleIdx >= (*meshIt)->trianglesOut.size())
+				{
+					triangleIdx -= static_cast<uint32_t>((*meshIt)->trianglesOut.size());
+					++meshIt;
+				}
+
+				return (*meshIt)->trianglesOut[triangleIdx];
+			};
+
+		// every visible pixel is shaded once, a row of depth blocks at a time
+		m_pThreadPool->ParallelFor(static_cast<uint32_t>(m_NrOfDepthBlocksY), [&](uint32_t blockY)
+			{
+				INT firstPixelIdx{};
+				INT lastPixelIdx{};
+				GetBlockRowPixels(blockY, firstPixelIdx, lastPixelIdx);
+
+				// runs of visible pixels are shaded and packed together
+				constexpr int maxRunLength{ 64 };
+				ColorRGB runColors[maxRunLength];
+
+				INT pixelIdx = firstPixelIdx;
+				while (pixelIdx < lastPixelIdx)
+				{
+					const INT runStart = pixelIdx;
+					int runLength{};
+
+					// the padding of the tiled layout is never covered
+					for (; pixelIdx < lastPixelIdx && runLength < maxRunLength; ++pixelIdx)
+					{
+						if (m_UseMultisampling == false)
+						{
+							const uint32_t triangleIdx = m_pVisibilityBuffer[pixelIdx];
+							if (triangleIdx == INVALID_TRIANGLE_ID)
+								break;
+
+							INT px{};
+							INT py{};
+							GetPixelPosition(pixelIdx, px, py);
+
+							const TriangleOut& triangle = getTriangle(triangleIdx);
+
+							if (const int shadingRate = GetShadingRate(px, py); shadingRate > 1)
+							{
+								runColors[runLength++] = ShadeCell(triangle, triangleIdx, px, py, shadingRate);
+								continue;
+							}
+
+							const PixelInterpolants interpolants = triangle.EvaluateInterpolants((px + 0.5f) - triangle.v0.position.x, (py + 0.5f) - triangle.v0.position.y);
+
+							runColors[runLength++] = ShadeFragment(interpolants, px, py, ReadDepth(px, py));
+							continue;
+						}
+
+						// with multisampling every visible triangle is weighted by its samples
+						const uint32_t* pTriangleIdxs = m_pVisibilityBuffer + pixelIdx * MSAA_SAMPLE_COUNT;
+
+						uint32_t remainingMask{};
+						for (int sample{}; sample < MSAA_SAMPLE_COUNT; ++sample)
+						{
+							if (pTriangleIdxs[sample] != INVALID_TRIANGLE_ID)
+								remainingMask |= 1u << sample;
+						}
+
+						if (remainingMask == 0)
+							break;
+
+						INT px{};
+						INT py{};
+						GetPixelPosition(pixelIdx, px, py);
+
+						ColorRGB pixelColor = m_BackGroundColor * static_cast<float>(MSAA_SAMPLE_COUNT - std::popcount(remainingMask));
+
+						while (remainingMask != 0)
+						{
+							const uint32_t triangleIdx = pTriangleIdxs[std::countr_zero(remainingMask)];
+
+							uint32_t triangleMask{};
+							for (uint32_t mask = remainingMask; mask != 0; mask &= mask - 1)
+							{
+								const int sample = std::countr_zero(mask);
+								if (pTriangleIdxs[sample] == triangleIdx)
+									triangleMask |= 1u << sample;
+							}
+							remainingMask &= ~triangleMask;
+
+							// shaded at the same place ShadeSamples would have picked
+							const TriangleOut& triangle = getTriangle(triangleIdx);
+							ColorRGB fragmentColor{};
+							if (const int shadingRate = GetShadingRate(px, py); shadingRate > 1)
+							{
+								fragmentColor = ShadeCell(triangle, triangleIdx, px, py, shadingRate);
+							}
+							else
+							{
+								float dx = (px + 0.5f) - triangle.v0.position.x;
+								float dy = (py + 0.5f) - triangle.v0.position.y;
+								if (triangleMask != MSAA_ALL_SAMPLES)
+								{
+									dx += MSAA_SAMPLE_OFFSETS_X[std::countr_zero(triangleMask)] / static_cast<float>(SUBPIXEL_SCALE);
+									dy += MSAA_SAMPLE_OFFSETS_Y[std::countr_zero(triangleMask)] / static_cast<float>(SUBPIXEL_SCALE);
+								}
+
+								fragmentColor = ShadeFragment(triangle.EvaluateInterpolants(dx, dy), px, py, triangle.depth.Evaluate(dx, dy));
+							}
+
+							// the forward path clamps the samples before averaging
+							if (m_UseHdrColorBuffer == false)
+								fragmentColor.MaxToOne();
+
+							pixelColor += fragmentColor * static_cast<float>(std::popcount(triangleMask));
+						}
+
+						runColors[runLength++] = pixelColor * (1.f / MSAA_SAMPLE_COUNT);
+					}
+
+					if (runLength == 0)
+					{
+						// an empty pixel ends the run
+						++pixelIdx;
+						continue;
+					}
+
+					if (m_UseHdrColorBuffer)
+						std::copy_n(runColors, runLength, m_pColorBufferPixels + runStart);
+					else
+						PackColors(runColors, GetColorTargetPixels() + runStart, runLength, ToneMapping::maxToOne);
+				}
+			});
+	}
+	void SoftwareRenderer::WritePixel(INT px, INT py, ColorRGB finalColor) const
+	{
+		if (m_UseMultisampling)
+		{
+			WriteSamples(px, py, finalColor, MSAA_ALL_SAMPLES);
+			return;
+		}
+
+		//Update Color in Buffer
+		if (m_UseHdrColorBuffer)
+			m_pColorBufferPixels[GetPixelIndex(px, py)] = finalColor;
+		else
+			GetColorTargetPixels()[GetPixelIndex(px, py)] = PackColor(finalColor);
+	}
+	void SoftwareRenderer::WriteSamples(INT px, INT py, ColorRGB finalColor, uint32_t sampleMask) const
+	{
+		const INT firstSampleIdx = GetPixelIndex(px, py) * MSAA_SAMPLE_COUNT;
+
+		if (m_UseHdrColorBuffer)
+		{
+			for (; sampleMask != 0; sampleMask &= sampleMask - 1)
+			{
+				m_pSampleColorBufferPixels[firstSampleIdx + std::countr_zero(sampleMask)] = finalColor;
+			}
+			return;
+		}
+
+		const uint32_t pixel = PackColor(finalColor);
+		for (; sampleMask != 0; sampleMask &= sampleMask - 1)
+		{
+			m_pSamplePixels[firstSampleIdx + std::countr_zero(sampleMask)] = pixel;
+		}
+	}
+	uint32_t SoftwareRenderer::PackColor(ColorRGB color) const
+	{
+		color.MaxToOne();
+
+		return static_cast<uint32_t>(static_cast<uint8_t>(color.r * 255)) << m_RedShift
+			| static_cast<uint32_t>(static_cast<uint8_t>(color.g * 255)) << m_GreenShift
+			| static_cast<uint32_t>(static_cast<uint8_t>(color.b * 255)) << m_BlueShift
+			| m_AlphaMask;
+	}
+	void SoftwareRenderer::PackColors(const ColorRGB* pColors, uint32_t* pPixels, int count, ToneMapping toneMapping) const
+	{
+		const __m128 one = _mm_set1_ps(1.f);
+		const __m128 scale = _mm_set1_ps(255.f);
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(m_AlphaMask));
+		const __m128i redShift = _mm_cvtsi32_si128(static_cast<int>(m_RedShift));
+		const __m128i greenShift = _mm_cvtsi32_si128(static_cast<int>(m_GreenShift));
+		const __m128i blueShift = _mm_cvtsi32_si128(static_cast<int>(m_BlueShift));
+
+		int i{};
+		for (; i + 4 <= count; i += 4)
+		{
+			// 4 colors are 3 registers: r0 g0 b0 r1 | g1 b1 r2 g2 | b2 r3 g3 b3
+			const float* pFloats = &pColors[i].r;
+			const __m128 a = _mm_loadu_ps(pFloats);
+			const __m128 b = _mm_loadu_ps(pFloats + 4);
+			const __m128 c = _mm_loadu_ps(pFloats + 8);
+
+			__m128 red = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 0, 3, 2)), _MM_SHUFFLE(3, 0, 3, 0));
+			__m128 green = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+			__m128 blue = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+
+			// same operations as ToneMap
+			switch (toneMapping)
+			{
+			case ToneMapping::maxToOne:
+			{
+				// ColorRGB::MaxToOne, dividing by one changes nothing
+				const __m128 maxValue = _mm_max_ps(_mm_max_ps(red, _mm_max_ps(green, blue)), one);
+				red = _mm_div_ps(red, maxValue);
+				green = _mm_div_ps(green, maxValue);
+				blue = _mm_div_ps(blue, maxValue);
+				break;
+			}
+			case ToneMapping::reinhard:
+				red = _mm_div_ps(red, _mm_add_ps(red, one));
+				green = _mm_div_ps(green, _mm_add_ps(green, one));
+				blue = _mm_div_ps(blue, _mm_add_ps(blue, one));
+				break;
+			case ToneMapping::aces:
+			{
+				const auto aces = [](__m128 x)
+					{
+						const __m128 numerator = _mm_mul_ps(x, _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(2.51f)), _mm_set1_ps(.03f)));
+						const __m128 denominator = _mm_add_ps(_mm_mul_ps(x, _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(2.43f)), _mm_set1_ps(.59f))), _mm_set1_ps(.14f));
+						return _mm_div_ps(numerator, denominator);
+					};
+				red = aces(red);
+				green = aces(green);
+				blue = aces(blue);
+				break;
+			}
+			}
+
+			// truncated and saturated to 8 bits: r0..r3 g0..g3 b0..b3
+			const __m128i channels = _mm_packus_epi16(
+				_mm_packs_epi32(_mm_cvttps_epi32(_mm_mul_ps(red, scale)), _mm_cvttps_epi32(_mm_mul_ps(green, scale))),
+				_mm_packs_epi32(_mm_cvttps_epi32(_mm_mul_ps(blue, scale)), zero));
+
+			// back to one channel per 32 bit lane, then into place
+			const __m128i redGreen = _mm_unpacklo_epi8(channels, zero);
+			const __m128i red32 = _mm_unpacklo_epi16(redGreen, zero);
+			const __m128i green32 = _mm_unpackhi_epi16(redGreen, zero);
+			const __m128i blue32 = _mm_unpacklo_epi16(_mm_unpackhi_epi8(channels, zero), zero);
+
+			const __m128i pixels = _mm_or_si128(_mm_or_si128(_mm_sll_epi32(red32, redShift), _mm_sll_epi32(green32, greenShift)),
+				_mm_or_si128(_mm_sll_epi32(blue32, blueShift), alphaMask));
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pPixels + i), pixels);
+		}
+
+		for (; i < count; ++i)
+		{
+			pPixels[i] = PackColor(ToneMap(pColors[i], toneMapping));
+		}
+	}
+	ColorRGB SoftwareRenderer::ToneMap(const ColorRGB& color, ToneMapping toneMapping) const
+	{
+		switch (toneMapping)
+		{
+		case ToneMapping::reinhard:
+			return { color.r / (color.r + 1.f), color.g / (color.g + 1.f), color.b / (color.b + 1.f) };
+		case ToneMapping::aces:
+		{
+			// Narkowicz's fit of the ACES filmic curve
+			const auto aces = [](float x)
+				{
+					return std::clamp((x * (x * 2.51f + .03f)) / (x * (x * 2.43f + .59f) + .14f), 0.f, 1.f);
+				};
+			return { aces(color.r), aces(color.g), aces(color.b) };
+		}
+		default:
+			// packing already scales the color back to one
+			return color;
+		}
+	}
+	void SoftwareRenderer::ResolveColorBuffer() const
+	{
+		// one streaming pass, both buffers have the same layout
+		m_pThreadPool->ParallelFor(static_cast<uint32_t>(m_NrOfDepthBlocksY), [&](uint32_t blockY)
+			{
+				INT firstPixelIdx{};
+				INT lastPixelIdx{};
+				GetBlockRowPixels(blockY, firstPixelIdx, lastPixelIdx);
+
+				PackColors(m_pColorBufferPixels + firstPixelIdx, GetColorTargetPixels() + firstPixelIdx, lastPixelIdx - firstPixelIdx, m_CurrentToneMapping);
+			});
+	}
+	void SoftwareRenderer::ResolveSamples() const
+	{
+		m_pThreadPool->ParallelFor(static_cast<uint32_t>(m_NrOfDepthBlocksY), [&](uint32_t blockY)
+			{
+				INT firstPixelIdx{};
+				INT lastPixelIdx{};
+				GetBlockRowPixels(blockY, firstPixelIdx, lastPixelIdx);
+
+				if (m_UseHdrColorBuffer)
+				{
+					// averaged while still linear, the tone mapping runs on the result
+					for (INT pixelIdx = firstPixelIdx; pixelIdx < lastPixelIdx; ++pixelIdx)
+					{
+						const ColorRGB* pSamples = m_pSampleColorBufferPixels + pixelIdx * MSAA_SAMPLE_COUNT;
+						m_pColorBufferPixels[pixelIdx] = (pSamples[0] + pSamples[1] + pSamples[2] + pSamples[3]) * (1.f / MSAA_SAMPLE_COUNT);
+					}
+					return;
+				}
+
+				// the 4 samples of a pixel fill one register, summed in 16 bit lanes
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i rounding = _mm_set1_epi16(MSAA_SAMPLE_COUNT / 2);
+				uint32_t* pPixels = GetColorTargetPixels();
+
+				for (INT pixelIdx = firstPixelIdx; pixelIdx < lastPixelIdx; ++pixelIdx)
+				{
+					const __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_pSamplePixels + pixelIdx * MSAA_SAMPLE_COUNT));
+
+					// samples 0 + 2 and 1 + 3, then the two halves
+					__m128i sum = _mm_add_epi16(_mm_unpacklo_epi8(samples, zero), _mm_unpackhi_epi8(samples, zero));
+					sum = _mm_add_epi16(sum, _mm_srli_si128(sum, 8));
+					sum = _mm_srli_epi16(_mm_add_epi16(sum, rounding), 2);
+
+					pPixels[pixelIdx] = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_packus_epi16(sum, sum)));
+				}
+			});
+	}
+	void SoftwareRenderer::PixelShading(VertexOut& v) const
+	{
+		ColorRGB tempColor{ colors::Black };
+
+		const Vector3 directionToLight = -Vector3{ .577f,-.577f,.577f };
+		constexpr float lightIntensity = 7.f;
+		constexpr float specularShininess = 25.f;
+
+		Vector3 normal;
+
+		if (m_EnableNormalMap)
+		{
+			// Normal map
+			const Vector3 biNormal = Vector3::Cross(v.normal, v.tangent);
+			const Matrix tangentSpaceAxis = { v.tangent, biNormal, v.normal, Vector3::Zero };
+
+			const ColorRGB normalColor = m_pVehicleNormalMap->Sample(v.uv);
+			Vector3 sampledNormal = { normalColor.r, normalColor.g, normalColor.b }; // => range [0, 1]
+			sampledNormal = 2.f * sampledNormal - Vector3{ 1, 1, 1 }; // => [0, 1] to [-1, 1]
+
+			sampledNormal = tangentSpaceAxis.TransformVector(sampledNormal);
+
+			normal = sampledNormal.Normalized();
+			////////////////////
+		}
+		else
+			normal = v.normal;
+
+		// Observed Area
+		const float lambertCos = Vector3::Dot(normal, directionToLight);
+		if (lambertCos < 0)
+			return;
+
+		const ColorRGB observedArea = { lambertCos, lambertCos, lambertCos };
+		////////////////////
+
+		ColorRGB diffuse;
+
+		// phong specular
+		const ColorRGB gloss = m_pVehicleGlossinessMap->Sample(v.uv);
+		const float exponent = gloss.r * specularShininess;
+
+		ColorRGB specular;
+		////////////////////////
+
+		switch (m_CurrentShadingMode)
+		{
+		case ShadingMode::observedArea:
+			tempColor += observedArea;
+			break;
+		case ShadingMode::diffuse:
+			diffuse = BRDF::Lambert(m_pVehicleDiffuse->Sample(v.uv));
+
+			tempColor += diffuse * observedArea * lightIntensity;
+			break;
+		case ShadingMode::specular:
+			specular = BRDF::Phong(m_pVehicleSpecularMap->Sample(v.uv), exponent, directionToLight, v.viewDirection, normal);
+
+			tempColor += specular * observedArea;
+			break;
+		case ShadingMode::combined:
+			specular = BRDF::Phong(m_pVehicleSpecularMap->Sample(v.uv), exponent, directionToLight, v.viewDirection, normal);
+			diffuse = BRDF::Lambert(m_pVehicleDiffuse->Sample(v.uv));
+
+			tempColor += diffuse * observedArea * lightIntensity + specular;
+			break;
+		}
+
+		constexpr ColorRGB ambient = { .025f,.025f,.025f };
+
+		tempColor += ambient;
+
+		v.color = tempColor;
+
+	}
+	uint8_t SoftwareRenderer::ComputeOutCode(const Vector4& position, float extent) const
+	{
+		// D3D clip volume: -w <= x <= w, -w <= y <= w, 0 <= z <= w
+		uint8_t outCode{};
+
+		if (position.z < 0)
+			outCode |= CLIP_NEAR;
+		if (position.z > position.w)
+			outCode |= CLIP_FAR;
+
+		if (position.x < -extent * position.w)
+			outCode |= CLIP_LEFT;
+		if (position.x > extent * position.w)
+			outCode |= CLIP_RIGHT;
+
+		if (position.y < -extent * position.w)
+			outCode |= CLIP_BOTTOM;
+		if (position.y > extent * position.w)
+			outCode |= CLIP_TOP;
+
+		return outCode;
+	}
+	float SoftwareRenderer::GetPlaneDistance(const Vector4& position, uint8_t plane) const
+	{
+		// positive on the inside of the plane
+		switch (plane)
+		{
+		case CLIP_NEAR:
+			return position.z;
+		case CLIP_LEFT:
+			return position.x + GUARD_BAND * position.w;
+		case CLIP_RIGHT:
+			return GUARD_BAND * position.w - position.x;
+		case CLIP_BOTTOM:
+			return position.y + GUARD_BAND * position.w;
+		case CLIP_TOP:
+			return GUARD_BAND * position.w - position.y;
+		default:
+			return position.w - position.z;
+		}
+	}
+	void SoftwareRenderer::PerspectiveDivide(VertexOut& v) const
+	{
+		v.position.x /= v.position.w;
+		v.position.y /= v.position.w;
+		v.position.z /= v.position.w;
+	}
+	void SoftwareRenderer::NDCToRaster(VertexOut& v) const
+	{
+		v.position.x = (v.position.x + 1) * 0.5f * (float)m_Width;
+		v.position.y = (1 - v.position.y) * 0.5f * (float)m_Height;
+
+		// snap to the sub-pixel grid of the rasterizer
+		v.position.x = std::round(v.position.x * SUBPIXEL_SCALE) / SUBPIXEL_SCALE;
+		v.position.y = std::round(v.position.y * SUBPIXEL_SCALE) / SUBPIXEL_SCALE;
+	}
+	void SoftwareRenderer::ClearTile(Tile& tile) const
+	{
+		const uint32_t backGroundPixel = PackColor(m_BackGroundColor);
+
+		if (m_UseTiledFrameBuffer == false)
+		{
+			for (INT py = tile.minY; py < tile.maxY; ++py)
+			{
+				ClearPixels(GetPixelIndex(tile.minX, py), tile.maxX - tile.minX, backGroundPixel);
+			}
+		}
+
+		// tiles are whole depth blocks, except at the edge of the screen
+		for (INT blockY = tile.minY / DEPTH_BLOCK_SIZE; blockY * DEPTH_BLOCK_SIZE < tile.maxY; ++blockY)
+		{
+			const INT blockMinX = tile.minX / DEPTH_BLOCK_SIZE;
+			const INT blockMaxX = (tile.maxX + DEPTH_BLOCK_SIZE - 1) / DEPTH_BLOCK_SIZE;
+
+			// the blocks of a tile are contiguous in the tiled layout
+			if (m_UseTiledFrameBuffer)
+				ClearPixels(GetPixelIndex(tile.minX, blockY * DEPTH_BLOCK_SIZE), (blockMaxX - blockMinX) * DEPTH_BLOCK_SIZE * DEPTH_BLOCK_SIZE, backGroundPixel);
+
+			std::fill_n(m_pCoarseDepthBufferPixels + blockMinX + blockY * m_NrOfDepthBlocksX, blockMaxX - blockMinX, FLT_MAX);
+
+			// compressed blocks write their pixels out on demand
+			if (m_CurrentDepthFormat == DepthFormat::planeCompressed)
+				std::fill_n(m_pDepthBlockStates + blockMinX + blockY * m_NrOfDepthBlocksX, blockMaxX - blockMinX, DepthBlockState::cleared);
+
+			if (m_CurrentShadingRate != ShadingRate::rate1x1)
+			{
+				std::fill_n(m_pShadingCellTriangles + (blockMinX + blockY * m_NrOfDepthBlocksX) * SHADING_CELLS_PER_BLOCK,
+					(blockMaxX - blockMinX) * SHADING_CELLS_PER_BLOCK, INVALID_TRIANGLE_ID);
+			}
+		}
+
+		tile.isCleared = true;
+	}
+	void SoftwareRenderer::ClearPixels(INT firstPixelIdx, INT nrOfPixels, uint32_t backGroundPixel) const
+	{
+		const INT nrOfSamples = GetNrOfSamples();
+
+		if (m_CurrentDepthFormat != DepthFormat::planeCompressed)
+			ClearDepth(firstPixelIdx * nrOfSamples, nrOfPixels * nrOfSamples);
+
+		if (m_CurrentRenderPath == RenderPath::visibilityBuffer)
+			std::fill_n(m_pVisibilityBuffer + firstPixelIdx * nrOfSamples, nrOfPixels * nrOfSamples, INVALID_TRIANGLE_ID);
+
+		if (m_UseHdrColorBuffer)
+			std::fill_n(m_pColorBufferPixels + firstPixelIdx, nrOfPixels, m_BackGroundColor);
+		else
+			std::fill_n(GetColorTargetPixels() + firstPixelIdx, nrOfPixels, backGroundPixel);
+
+		// the visibility buffer is resolved straight from its samples
+		if (m_UseMultisampling == false || m_CurrentRenderPath == RenderPath::visibilityBuffer)
+			return;
+
+		if (m_UseHdrColorBuffer)
+			std::fill_n(m_pSampleColorBufferPixels + firstPixelIdx * MSAA_SAMPLE_COUNT, nrOfPixels * MSAA_SAMPLE_COUNT, m_BackGroundColor);
+		else
+			std::fill_n(m_pSamplePixels + firstPixelIdx * MSAA_SAMPLE_COUNT, nrOfPixels * MSAA_SAMPLE_COUNT, backGroundPixel);
+	}
+	void SoftwareRenderer::ClearBackground() const
+	{
+		if (m_UseMultisampling && m_CurrentRenderPath != RenderPath::visibilityBuffer)
+		{
+			if (m_UseHdrColorBuffer)
+				std::fill_n(m_pSampleColorBufferPixels, m_NrOfBufferPixels * MSAA_SAMPLE_COUNT, m_BackGroundColor);
+			else
+				std::fill_n(m_pSamplePixels, m_NrOfBufferPixels * MSAA_SAMPLE_COUNT, PackColor(m_BackGroundColor));
+		}
+
+		if (m_UseHdrColorBuffer)
+			std::fill_n(m_pColorBufferPixels, m_NrOfBufferPixels, m_BackGroundColor);
+		else if (m_UseTiledFrameBuffer)
+			std::fill_n(m_pTiledBackBufferPixels, m_NrOfBufferPixels, PackColor(m_BackGroundColor));
+		else
+			SDL_FillRect(m_pBackBuffer, nullptr, PackColor(m_BackGroundColor));
+	}
+	INT SoftwareRenderer::GetNrOfSamples() const
+	{
+		return m_UseMultisampling ? MSAA_SAMPLE_COUNT : 1;
+	}
+	INT SoftwareRenderer::GetPixelIndex(INT px, INT py) const
+	{
+		if (m_UseTiledFrameBuffer == false)
+			return px + (py * m_Width);
+
+		const INT blockIdx = px / DEPTH_BLOCK_SIZE + (py / DEPTH_BLOCK_SIZE) * m_NrOfDepthBlocksX;
+		return blockIdx * DEPTH_BLOCK_SIZE * DEPTH_BLOCK_SIZE + px % DEPTH_BLOCK_SIZE + (py % DEPTH_BLOCK_SIZE) * DEPTH_BLOCK_SIZE;
+	}
+	void SoftwareRenderer::GetPixelPosition(INT pixelIdx, INT& px, INT& py) const
+	{
+		if (m_UseTiledFrameBuffer == false)
+		{
+			px = pixelIdx % m_Width;
+			py = pixelIdx / m_Width;
+			return;
+		}
+
+		const INT blockIdx = pixelIdx / (DEPTH_BLOCK_SIZE * DEPTH_BLOCK_SIZE);
+		const INT blockPixelIdx = pixelIdx % (DEPTH_BLOCK_SIZE * DEPTH_BLOCK_SIZE);
+		px = (blockIdx % m_NrOfDepthBlocksX) * DEPTH_BLOCK_SIZE + blockPixelIdx % DEPTH_BLOCK_SIZE;
+		py = (blockIdx / m_NrOfDepthBlocksX) * DEPTH_BLOCK_SIZE + blockPixelIdx / DEPTH_BLOCK_SIZE;
+	}
+	void SoftwareRenderer::GetBlockRowPixels(INT blockY, INT& firstPixelIdx, INT& lastPixelIdx) const
+	{
+		// a row of depth blocks is one contiguous range, the last index is exclusive
+		if (m_UseTiledFrameBuffer == false)
+		{
+			firstPixelIdx = blockY * DEPTH_BLOCK_SIZE * m_Width;
+			lastPixelIdx = std::min((blockY + 1) * DEPTH_BLOCK_SIZE, m_Height) * m_Width;
+			return;
+		}
+
+		firstPixelIdx = blockY * m_NrOfDepthBlocksX * DEPTH_BLOCK_SIZE * DEPTH_BLOCK_SIZE;
+		lastPixelIdx = firstPixelIdx + m_NrOfDepthBlocksX * DEPTH_BLOCK_SIZE * DEPTH_BLOCK_SIZE;
+	}
+	uint32_t* SoftwareRenderer::GetColorTargetPixels() const
+	{
+		return m_UseTiledFrameBuffer ? m_pTiledBackBufferPixels : m_pBackBufferPixels;
+	}
+	void SoftwareRenderer::DetileBackBuffer() const
+	{
+		// every block row to its place, the pixels outside of the screen are dropped
+		m_pThreadPool->ParallelFor(static_cast<uint32_t>(m_NrOfDepthBlocksY), [&](uint32_t blockY)
+			{
+				const INT minY = blockY * DEPTH_BLOCK_SIZE;
+				const INT maxY = std::min(minY + DEPTH_BLOCK_SIZE, m_Height);
+
+				for (INT blockX{}; blockX < m_NrOfDepthBlocksX; ++blockX)
+				{
+					const INT minX = blockX * DEPTH_BLOCK_SIZE;
+					const INT width = std::min(DEPTH_BLOCK_SIZE, m_Width - minX);
+
+					for (INT py = minY; py < maxY; ++py)
+					{
+						std::copy_n(m_pTiledBackBufferPixels + GetPixelIndex(minX, py), width, m_pBackBufferPixels + minX + (py * m_Width));
+					}
+				}
+			});
+	}
+#pragma endregion
+}
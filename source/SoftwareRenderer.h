@@ -1,7 +1,400 @@
 #pragma once
-#include "Renderer.h"
-class SoftwareRenderer final :
-    public Renderer
+#include "Mesh.h"
+#include <map>
+
+struct SDL_Window;
+struct SDL_Surface;
+
+class Camera;
+class Mesh;
+class ShadedEffect;
+
+namespace dae
 {
-};
+	class Texture;
+	class ThreadPool;
+	class WorkerThread;
+
+	class SoftwareRenderer final
+	{
+	public:
+		SoftwareRenderer(SDL_Window* pWindow, const Camera* pCamera, std::map<Mesh*, ShadedEffect*>* pMeshToShadedEffectMap);
+		~SoftwareRenderer();
+
+		SoftwareRenderer(const SoftwareRenderer&) = delete;
+		SoftwareRenderer(SoftwareRenderer&&) noexcept = delete;
+		SoftwareRenderer& operator=(const SoftwareRenderer&) = delete;
+		SoftwareRenderer& operator=(SoftwareRenderer&&) noexcept = delete;
+
+		void Update(float elapsedTime);
+		void Render() const;
+
+		void SetBackGroundColor(const ColorRGB& color);
+		void SetVehicleTextures(const Texture* pDiffuse, const Texture* pNormalMap, const Texture* pGlossinessMap, const Texture* pSpecularMap);
+		// the triangles of the pipelined frame are not rasterized, for changes made outside of the software renderer
+		void InvalidateTriangles();
+
+		void CycleCullMode();
+		void CycleShadingMode();
+		void ToggleNormalMap();
+		void ToggleDepthBufferVisualization();
+		void ToggleBoundingBoxVisualization();
+		void ToggleTileBinning();
+		void ToggleHierarchicalDepth();
+		void CycleRenderPath();
+		void CycleRasterTraversal();
+		void TogglePipelinedFrames();
+		void ToggleHdrColorBuffer();
+		void CycleToneMapping();
+		void CycleDepthFormat();
+		void ToggleTiledFrameBuffer();
+		void ToggleMultisampling();
+		void ToggleDynamicResolution();
+		void CycleShadingRate();
+		void ToggleOcclusionCulling();
+
+	private:
+		enum class CullMode
+		{
+			back,
+			front,
+			none
+		};
+		enum class ShadingMode
+		{
+			observedArea,
+			diffuse,
+			specular,
+			combined
+		};
+		enum class RenderPath
+		{
+			forward,
+			visibilityBuffer,
+			depthPrepass
+		};
+		enum class RasterTraversal
+		{
+			boundingBox,
+			scanline,
+			hierarchical
+		};
+		enum class BlockCoverage
+		{
+			outside,
+			partial,
+			inside
+		};
+		enum class RasterPass
+		{
+			depthAndColor,
+			depthOnly,
+			equalDepthColor
+		};
+		enum class ToneMapping
+		{
+			maxToOne,
+			reinhard,
+			aces
+		};
+		enum class DepthFormat
+		{
+			float32,
+			unorm24,
+			unorm16,
+			planeCompressed
+		};
+		enum class ShadingRate
+		{
+			rate1x1,
+			rate2x2,
+			rate4x4,
+			adaptive
+		};
+		enum class DepthBlockState : uint8_t
+		{
+			pixels,
+			cleared,
+			plane
+		};
+
+		SDL_Window* m_pWindow{};
+		const Camera* m_pCamera{};
+		std::map<Mesh*, ShadedEffect*>* m_pMeshToShadedEffectMap{};
+
+		const Texture* m_pVehicleDiffuse{};
+		const Texture* m_pVehicleNormalMap{};
+		const Texture* m_pVehicleGlossinessMap{};
+		const Texture* m_pVehicleSpecularMap{};
+
+		SDL_Surface* m_pFrontBuffer{ nullptr };
+		SDL_Surface* m_pBackBuffer{ nullptr };
+		uint32_t* m_pBackBufferPixels{};
+
+		// render target of the tiled layout, copied to the back buffer at the end of the frame
+		uint32_t* m_pTiledBackBufferPixels{};
+
+		// channel positions of a back buffer pixel
+		uint32_t m_RedShift{};
+		uint32_t m_GreenShift{};
+		uint32_t m_BlueShift{};
+		uint32_t m_AlphaMask{};
+
+		// HDR color buffer, tone mapped into the back buffer
+		ColorRGB* m_pColorBufferPixels{};
+
+		// MSAA samples, the samples of a pixel are next to each other (in the depth and visibility buffer as well)
+		uint32_t* m_pSamplePixels{};
+		ColorRGB* m_pSampleColorBufferPixels{};
+
+		// depth codes, the nearest depth has the smallest code (4 bytes per sample, unorm24 uses 3 of them)
+		uint8_t* m_pDepthBuffer{};
+
+		static constexpr uint32_t DEPTH_UNORM24_MAX{ (1 << 24) - 1 };
+		static constexpr uint32_t DEPTH_UNORM16_MAX{ (1 << 16) - 1 };
+
+		// max depth per DEPTH_BLOCK_SIZE x DEPTH_BLOCK_SIZE block
+		static constexpr int DEPTH_BLOCK_SIZE{ 8 };
+
+		float* m_pCoarseDepthBufferPixels{};
+		int m_NrOfDepthBlocksX{};
+		int m_NrOfDepthBlocksY{};
+
+		// planeCompressed: cleared blocks and blocks covered by one triangle store no pixels
+		DepthBlockState* m_pDepthBlockStates{};
+		const TriangleOut** m_pDepthBlockPlanes{};
+
+		// occluder depth per depth block, a block only takes a depth once its coverage mask is complete
+		float* m_pOccluderDepthBuffer{};
+		uint64_t* m_pOccluderCoverage{};
+		float* m_pOccluderCoverageDepths{};
+		static_assert(DEPTH_BLOCK_SIZE * DEPTH_BLOCK_SIZE == 64, "the coverage of a block is a 64 bit mask");
+
+		// margin a compressed plane keeps from the edges of the depth range
+		static constexpr float DEPTH_PLANE_MARGIN{ 1e-5f };
+
+		static constexpr uint32_t INVALID_TRIANGLE_ID{ UINT32_MAX };
+
+		// triangle id per pixel, ids continue from one mesh to the next
+		// (the depth prepass keeps it too with the unorm depth formats)
+		uint32_t* m_pVisibilityBuffer{};
+
+		// coarse shading: the last triangle and color of every shading cell, the cells of a depth block are next to each other
+		static constexpr int SHADING_CELLS_PER_BLOCK{ (DEPTH_BLOCK_SIZE / 2) * (DEPTH_BLOCK_SIZE / 2) };
+
+		uint32_t* m_pShadingCellTriangles{};
+		ColorRGB* m_pShadingCellColors{};
+
+		// the buffers are allocated for the window, the render resolution can be lower
+		int m_WindowWidth{};
+		int m_WindowHeight{};
+
+		int m_Width{};
+		int m_Height{};
+
+		// pixels per buffer, the tiled layout rounds up to whole depth blocks
+		int m_NrOfBufferPixels{};
+
+		struct Tile
+		{
+			int minX{};
+			int minY{};
+			int maxX{};
+			int maxY{};
+
+			std::vector<uint32_t> triangleIndices{};
+
+			// cleared right before the first triangle that touches it
+			bool isCleared{};
+
+			// adaptive shading rate, picked from the previous frame
+			int shadingRate{ 1 };
+		};
+
+		static constexpr int TILE_SIZE{ 64 };
+		static_assert(TILE_SIZE % DEPTH_BLOCK_SIZE == 0, "a depth block can not be shared between tiles");
+
+		// the adaptive shading rate compares the luminance of pixels this far apart
+		static constexpr int SHADING_RATE_PROBE_DISTANCE{ 4 };
+		// average luminance change per pixel (0 - 255) below which a tile is shaded 4x4 or 2x2
+		static constexpr float SHADING_RATE_4X4_GRADIENT{ 3.f };
+		static constexpr float SHADING_RATE_2X2_GRADIENT{ 10.f };
+
+		Tile* m_pTiles{};
+		int m_NrOfTilesX{};
+		int m_NrOfTilesY{};
+
+		ThreadPool* m_pThreadPool{};
+		// rasterizes the previous frame of the pipelined mode
+		WorkerThread* m_pRasterThread{};
+		// the resolution, cull mode, multisampling or scene changed, the pipelined triangles are outdated
+		bool m_HasAssemblyChanged{ false };
+		bool m_AreTrianglesOutdated{ false };
+
+		// vertices per transform job, a multiple of the SSE batches
+		static constexpr size_t VERTEX_CHUNK_SIZE{ 4096 };
+		static_assert(VERTEX_CHUNK_SIZE % 4 == 0, "a vertex batch can not be shared between chunks");
+
+		// clip space planes, used as outcode bits
+		static constexpr uint8_t CLIP_NEAR{ 1 << 0 };
+		static constexpr uint8_t CLIP_FAR{ 1 << 1 };
+		static constexpr uint8_t CLIP_LEFT{ 1 << 2 };
+		static constexpr uint8_t CLIP_RIGHT{ 1 << 3 };
+		static constexpr uint8_t CLIP_BOTTOM{ 1 << 4 };
+		static constexpr uint8_t CLIP_TOP{ 1 << 5 };
+
+		// NDC x/y extent that is scissored instead of clipped
+		static constexpr float GUARD_BAND{ 8.f };
+
+		// 24.8 fixed point raster positions
+		static constexpr int SUBPIXEL_BITS{ 8 };
+		static constexpr int SUBPIXEL_SCALE{ 1 << SUBPIXEL_BITS };
+		// one extra vertex per clip plane
+		static constexpr int MAX_CLIPPED_VERTICES{ 3 + 5 };
+
+		// pixels per coverage evaluation
+#if defined(__AVX2__)
+		static constexpr int COVERAGE_SPAN{ 8 };
+#else
+		static constexpr int COVERAGE_SPAN{ 4 };
+#endif
+
+		// triangles up to STAMP_SIZE x STAMP_SIZE pixels take the stamp path
+		static constexpr int STAMP_SIZE{ 4 };
+
+		// 4x MSAA rotated grid, in sub-pixels from the pixel center
+		static constexpr int MSAA_SAMPLE_COUNT{ 4 };
+		static constexpr int MSAA_SAMPLE_OFFSETS_X[MSAA_SAMPLE_COUNT]{ -2 * SUBPIXEL_SCALE / 16, 6 * SUBPIXEL_SCALE / 16, -6 * SUBPIXEL_SCALE / 16, 2 * SUBPIXEL_SCALE / 16 };
+		static constexpr int MSAA_SAMPLE_OFFSETS_Y[MSAA_SAMPLE_COUNT]{ -6 * SUBPIXEL_SCALE / 16, -2 * SUBPIXEL_SCALE / 16, 2 * SUBPIXEL_SCALE / 16, 6 * SUBPIXEL_SCALE / 16 };
+		static constexpr int MSAA_SAMPLE_EXTENT{ 6 * SUBPIXEL_SCALE / 16 };
+		static constexpr uint32_t MSAA_ALL_SAMPLES{ (1u << MSAA_SAMPLE_COUNT) - 1 };
+		static_assert(COVERAGE_SPAN % MSAA_SAMPLE_COUNT == 0, "the samples of a pixel can not be shared between coverage spans");
+
+		// fixed point edge functions, relative to the center of the first pixel
+		struct EdgeSetup
+		{
+			// the maximum is exclusive
+			INT minX;
+			INT minY;
+			INT maxX;
+			INT maxY;
+
+			int64_t origins[3];
+			int64_t stepsX[3];
+			int64_t stepsY[3];
+			int64_t laneOffsets[3 * COVERAGE_SPAN];
+			// MSAA only, the lanes as the samples of COVERAGE_SPAN / MSAA_SAMPLE_COUNT pixels
+			int64_t sampleLaneOffsets[3 * COVERAGE_SPAN];
+		};
+
+		//KeyBind Variables
+		CullMode m_CurrentCullMode{ CullMode::back };
+
+		ColorRGB m_BackGroundColor;
+
+		ShadingMode m_CurrentShadingMode{ ShadingMode::combined };
+
+		bool m_EnableNormalMap{ true };
+		bool m_DepthBufferVisualization{ false };
+		bool m_BoundingBoxVisualization{ false };
+		bool m_UseTileBinning{ true };
+		bool m_UseHierarchicalDepth{ true };
+		RenderPath m_CurrentRenderPath{ RenderPath::forward };
+		RasterTraversal m_CurrentRasterTraversal{ RasterTraversal::hierarchical };
+		bool m_UsePipelinedFrames{ false };
+		bool m_UseHdrColorBuffer{ false };
+		ToneMapping m_CurrentToneMapping{ ToneMapping::maxToOne };
+		DepthFormat m_CurrentDepthFormat{ DepthFormat::float32 };
+		bool m_UseTiledFrameBuffer{ true };
+		bool m_UseMultisampling{ false };
+		bool m_UseDynamicResolution{ false };
+		ShadingRate m_CurrentShadingRate{ ShadingRate::rate1x1 };
+		bool m_UseOcclusionCulling{ true };
+
+		// dynamic resolution, the render scale follows the square root of the frame time
+		static constexpr float TARGET_FRAME_TIME{ 1.f / 60.f };
+		static constexpr float MIN_RENDER_SCALE{ 0.5f };
+		static constexpr float RENDER_SCALE_STEP{ 0.125f };
+		// load under which the scale grows again
+		static constexpr float RENDER_SCALE_HEADROOM{ 0.75f };
+		// frames between two changes
+		static constexpr int RENDER_SCALE_SETTLE_FRAMES{ 15 };
+		static constexpr float FRAME_TIME_SMOOTHING{ 0.2f };
+
+		float m_RenderScale{ 1.f };
+		float m_AverageFrameTime{};
+		int m_FramesSinceResolutionChange{};
+		//////////////
+
+		void UpdateRenderScale(float elapsedTime);
+		void SetRenderResolution(int width, int height);
+
+		void ProcessGeometry(bool isPipelined) const;
+		void RasterizeOccluder(const TriangleOut& triangle, INT minBlockY, INT maxBlockY) const;
+		bool IsMeshOccluded(const Mesh& mesh) const;
+		void RenderTriangleList(const Mesh& mesh, uint32_t firstTriangleId, RasterPass pass) const;
+		void RasterizeFrame() const;
+		void AssembleTriangles(const Mesh& mesh, std::vector<TriangleOut>& trianglesOut) const;
+		void EmitTriangle(std::vector<TriangleOut>& trianglesOut, const VertexOut& vOut0, const VertexOut& vOut1, const VertexOut& vOut2) const;
+		void SetupTriangle(TriangleOut& triangle, int64_t fixedArea) const;
+		int ClipPolygon(VertexOut* pPolygon, int nrOfVertices, uint8_t clipPlanes) const;
+		void BinTriangles(const Mesh& mesh) const;
+		void RasterizeTriangle(const TriangleOut& triangle, uint32_t triangleId, RasterPass pass, int clipMinX, int clipMinY, int clipMaxX, int clipMaxY) const;
+		void RasterizeStamp(const TriangleOut& triangle, uint32_t triangleId, RasterPass pass, int clipMinX, int clipMinY, int clipMaxX, int clipMaxY) const;
+		void SetupEdges(const TriangleOut& triangle, EdgeSetup& edges) const;
+		uint32_t EvaluateStamp(const EdgeSetup& edges, int nrOfRows) const;
+		void RasterizeBoundingBox(const TriangleOut& triangle, uint32_t triangleId, RasterPass pass, const EdgeSetup& edges) const;
+		void RasterizeScanlines(const TriangleOut& triangle, uint32_t triangleId, RasterPass pass, const EdgeSetup& edges) const;
+		void RasterizeHierarchical(const TriangleOut& triangle, uint32_t triangleId, RasterPass pass, const EdgeSetup& edges) const;
+		BlockCoverage ClassifyBlock(const EdgeSetup& edges, INT minX, INT minY, INT maxX, INT maxY) const;
+		bool RasterizeBlock(const TriangleOut& triangle, uint32_t triangleId, RasterPass pass, const EdgeSetup& edges,
+			INT minX, INT minY, INT maxX, INT maxY, bool testCoverage) const;
+		uint32_t EvaluateEdgeFunctions(const int64_t* pEdgeValues, const int64_t* pLaneOffsets) const;
+		bool ShadePixel(const TriangleOut& triangle, uint32_t triangleId, RasterPass pass, INT px, INT py, const PixelInterpolants* pInterpolants) const;
+		void RasterizeMultisampled(const TriangleOut& triangle, uint32_t triangleId, RasterPass pass, const EdgeSetup& edges) const;
+		bool RasterizeSampleBlock(const TriangleOut& triangle, uint32_t triangleId, RasterPass pass, const EdgeSetup& edges,
+			INT minX, INT minY, INT maxX, INT maxY, bool testCoverage) const;
+		bool ShadeSamples(const TriangleOut& triangle, uint32_t triangleId, RasterPass pass, INT px, INT py, uint32_t sampleMask) const;
+		void WriteSamples(INT px, INT py, ColorRGB finalColor, uint32_t sampleMask) const;
+		void ResolveSamples() const;
+		INT GetNrOfSamples() const;
+		ColorRGB ShadeFragment(const PixelInterpolants& interpolants, INT px, INT py, float depth) const;
+		int GetShadingRate(INT px, INT py) const;
+		ColorRGB ShadeCell(const TriangleOut& triangle, uint32_t triangleId, INT px, INT py, int shadingRate) const;
+		void UpdateShadingRates() const;
+		void ResolveVisibilityBuffer() const;
+		void WritePixel(INT px, INT py, ColorRGB finalColor) const;
+		uint32_t PackColor(ColorRGB color) const;
+		void PackColors(const ColorRGB* pColors, uint32_t* pPixels, int count, ToneMapping toneMapping) const;
+		ColorRGB ToneMap(const ColorRGB& color, ToneMapping toneMapping) const;
+		void ResolveColorBuffer() const;
+		void UpdateCoarseDepth(INT blockX, INT blockY) const;
+		uint32_t EncodeDepth(float depth) const;
+		float DecodeDepth(uint32_t depthCode) const;
+		uint32_t ReadDepthCode(INT pixelIdx) const;
+		void WriteDepthCode(INT pixelIdx, uint32_t depthCode) const;
+		float ReadDepth(INT px, INT py) const;
+		void ClearDepth(INT firstPixelIdx, INT nrOfPixels) const;
+		bool IsDepthQuantized() const;
+		bool CompressDepthBlock(const TriangleOut& triangle, uint32_t triangleId, RasterPass pass, INT blockX, INT blockY) const;
+		void DecompressDepthBlock(INT blockX, INT blockY) const;
+		void VertexTransformationFunction(Mesh& meshes, bool isParallel) const;
+		void TransformVertices(Mesh& m, const Matrix& worldViewProjectionMatrix, size_t first, size_t last) const;
+		void PixelShading(VertexOut& v) const;
+
+		uint8_t ComputeOutCode(const Vector4& position, float extent) const;
+		float GetPlaneDistance(const Vector4& position, uint8_t plane) const;
+		void PerspectiveDivide(VertexOut& v) const;
+		void NDCToRaster(VertexOut& v) const;
+
+		void ClearBackground() const;
+		void ClearTile(Tile& tile) const;
+		void ClearPixels(INT firstPixelIdx, INT nrOfPixels, uint32_t backGroundPixel) const;
 
+		INT GetPixelIndex(INT px, INT py) const;
+		void GetPixelPosition(INT pixelIdx, INT& px, INT& py) const;
+		void GetBlockRowPixels(INT blockY, INT& firstPixelIdx, INT& lastPixelIdx) const;
+		uint32_t* GetColorTargetPixels() const;
+		void DetileBackBuffer() const;
+	};
+}
@@ -0,0 +1,152 @@
+#include "pch.h"
+#include "ThreadPool.h"
+
+namespace dae
+{
+	ThreadPool::ThreadPool(uint32_t nrOfThreads)
+	{
+		// the calling thread counts as one
+		const uint32_t nrOfWorkers = nrOfThreads > 1 ? nrOfThreads - 1 : 0;
+
+		m_Workers.reserve(nrOfWorkers);
+		for (uint32_t i{}; i < nrOfWorkers; ++i)
+		{
+			m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_IsStopping = true;
+		}
+		m_WorkCondition.notify_all();
+
+		for (auto& worker : m_Workers)
+		{
+			worker.join();
+		}
+	}
+
+	void ThreadPool::ParallelFor(uint32_t count, const std::function<void(uint32_t)>& job)
+	{
+		if (count == 0)
+			return;
+
+		if (m_Workers.empty() || count == 1)
+		{
+			for (uint32_t i{}; i < count; ++i)
+				job(i);
+			return;
+		}
+
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_pJob = &job;
+			m_JobCount = count;
+			m_NextJobIndex = 0;
+			m_BusyWorkers = static_cast<uint32_t>(m_Workers.size());
+			++m_Generation;
+		}
+		m_WorkCondition.notify_all();
+
+		RunJobs();
+
+		// every worker has to check in before the job goes out of scope
+		std::unique_lock lock{ m_Mutex };
+		m_DoneCondition.wait(lock, [this] { return m_BusyWorkers == 0; });
+		m_pJob = nullptr;
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		uint64_t lastGeneration{};
+
+		while (true)
+		{
+			{
+				std::unique_lock lock{ m_Mutex };
+				m_WorkCondition.wait(lock, [&] { return m_IsStopping || m_Generation != lastGeneration; });
+
+				if (m_IsStopping)
+					return;
+
+				lastGeneration = m_Generation;
+			}
+
+			RunJobs();
+
+			{
+				std::lock_guard lock{ m_Mutex };
+				--m_BusyWorkers;
+			}
+			m_DoneCondition.notify_one();
+		}
+	}
+
+	void ThreadPool::RunJobs()
+	{
+		for (uint32_t i = m_NextJobIndex++; i < m_JobCount; i = m_NextJobIndex++)
+		{
+			(*m_pJob)(i);
+		}
+	}
+
+	WorkerThread::WorkerThread()
+	{
+		// started only once every other member is initialized
+		m_Thread = std::thread{ &WorkerThread::WorkerLoop, this };
+	}
+
+	WorkerThread::~WorkerThread()
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_IsStopping = true;
+		}
+		m_WorkCondition.notify_one();
+
+		m_Thread.join();
+	}
+
+	void WorkerThread::Start(const std::function<void()>& job)
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_pJob = &job;
+		}
+		m_WorkCondition.notify_one();
+	}
+
+	void WorkerThread::Wait()
+	{
+		std::unique_lock lock{ m_Mutex };
+		m_DoneCondition.wait(lock, [this] { return m_pJob == nullptr; });
+	}
+
+	void WorkerThread::WorkerLoop()
+	{
+		while (true)
+		{
+			const std::function<void()>* pJob{};
+			{
+				std::unique_lock lock{ m_Mutex };
+				m_WorkCondition.wait(lock, [this] { return m_IsStopping || m_pJob != nullptr; });
+
+				if (m_IsStopping)
+					return;
+
+				pJob = m_pJob;
+			}
+
+			(*pJob)();
+
+			{
+				std::lock_guard lock{ m_Mutex };
+				m_pJob = nullptr;
+			}
+			m_DoneCondition.notify_one();
+		}
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+//Standard includes
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dae
+{
+	class ThreadPool final
+	{
+	public:
+		explicit ThreadPool(uint32_t nrOfThreads = std::thread::hardware_concurrency());
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) noexcept = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool& operator=(ThreadPool&&) noexcept = delete;
+
+		// Calls job(index) for every index in [0, count) and blocks until all of them are done.
+		// The calling thread takes part in the work, so this also works without any workers.
+		void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& job);
+
+		uint32_t GetNrOfThreads() const { return static_cast<uint32_t>(m_Workers.size()) + 1; }
+
+	private:
+		std::vector<std::thread> m_Workers{};
+
+		std::mutex m_Mutex{};
+		std::condition_variable m_WorkCondition{};
+		std::condition_variable m_DoneCondition{};
+
+		const std::function<void(uint32_t)>* m_pJob{ nullptr };
+		uint32_t m_JobCount{};
+		std::atomic<uint32_t> m_NextJobIndex{};
+
+		uint64_t m_Generation{};
+		uint32_t m_BusyWorkers{};
+		bool m_IsStopping{ false };
+
+		void WorkerLoop();
+		void RunJobs();
+	};
+
+	// A single thread that stays alive for the lifetime of the object and runs one job at a time next to the calling thread.
+	class WorkerThread final
+	{
+	public:
+		WorkerThread();
+		~WorkerThread();
+
+		WorkerThread(const WorkerThread&) = delete;
+		WorkerThread(WorkerThread&&) noexcept = delete;
+		WorkerThread& operator=(const WorkerThread&) = delete;
+		WorkerThread& operator=(WorkerThread&&) noexcept = delete;
+
+		// Hands the job to the thread and returns right away, the job has to stay alive until Wait returns.
+		void Start(const std::function<void()>& job);
+		// Blocks until the job given to Start is done.
+		void Wait();
+
+	private:
+		std::thread m_Thread{};
+
+		std::mutex m_Mutex{};
+		std::condition_variable m_WorkCondition{};
+		std::condition_variable m_DoneCondition{};
+
+		const std::function<void()>* m_pJob{ nullptr };
+		bool m_IsStopping{ false };
+
+		void WorkerLoop();
+	};
+}
@@ -81,7 +81,21 @@ int main(int argc, char* args[])
 		<< "  [F5]  Cycle Shading Mode (COMBINED/OBSERVED AREA/DIFFUSE/SPECULAR)\n"
 		<< "  [F6]  Toggle NormalMap (ON/OFF)\n"
 		<< "  [F7]  Toggle DepthBuffer Visualization (ON/OFF)\n"
-		<< "  [F8]  Toggle BoundingBox Visualization (ON/OFF)\n";
+		<< "  [F8]  Toggle BoundingBox Visualization (ON/OFF)\n"
+		<< "  [T]   Toggle Tile Binning (ON/OFF)\n"
+		<< "  [H]   Toggle Hierarchical DepthBuffer (ON/OFF)\n"
+		<< "  [V]   Cycle Render Path (FORWARD/VISIBILITY BUFFER/DEPTH PREPASS)\n"
+		<< "  [R]   Cycle Raster Traversal (HIERARCHICAL/BOUNDING BOX/SCANLINE)\n"
+		<< "  [P]   Toggle Pipelined Frames (ON/OFF)\n"
+		<< "  [B]   Toggle HDR ColorBuffer (ON/OFF)\n"
+		<< "  [M]   Cycle Tone Mapping (MAX TO ONE/REINHARD/ACES)\n"
+		<< "  [Z]   Cycle Depth Format (FLOAT32/UNORM24/UNORM16/PLANE COMPRESSED)\n"
+		<< "  [L]   Toggle Tiled FrameBuffer (ON/OFF)\n"
+		<< "  [X]   Toggle MSAA 4x (ON/OFF)\n"
+		<< "  [G]   Toggle Dynamic Resolution (ON/OFF)\n"
+		<< "  [K]   Cycle Shading Rate (1X1/2X2/4X4/ADAPTIVE)\n"
+		<< "  [O]   Toggle Occlusion Culling (ON/OFF)\n"
+		<< "  [J]   Toggle Hidden Vehicle (ON/OFF)\n";
 	SetConsoleTextAttribute(h, 7);
 
 	//Initialize "framework"
@@ -115,6 +129,20 @@ int main(int argc, char* args[])
 				else if (e.key.keysym.scancode == SDL_SCANCODE_F9) { pRenderer->CycleCullMode(); }
 				else if (e.key.keysym.scancode == SDL_SCANCODE_F10) { pRenderer->ToggleUniformClearColor(); }
 				else if (e.key.keysym.scancode == SDL_SCANCODE_F11) { ToggleDisplayFPS(); }
+				else if (e.key.keysym.scancode == SDL_SCANCODE_T) { pRenderer->ToggleTileBinning(); }
+				else if (e.key.keysym.scancode == SDL_SCANCODE_H) { pRenderer->ToggleHierarchicalDepth(); }
+				else if (e.key.keysym.scancode == SDL_SCANCODE_V) { pRenderer->CycleRenderPath(); }
+				else if (e.key.keysym.scancode == SDL_SCANCODE_R) { pRenderer->CycleRasterTraversal(); }
+				else if (e.key.keysym.scancode == SDL_SCANCODE_P) { pRenderer->TogglePipelinedFrames(); }
+				else if (e.key.keysym.scancode == SDL_SCANCODE_B) { pRenderer->ToggleHdrColorBuffer(); }
+				else if (e.key.keysym.scancode == SDL_SCANCODE_M) { pRenderer->CycleToneMapping(); }
+				else if (e.key.keysym.scancode == SDL_SCANCODE_Z) { pRenderer->CycleDepthFormat(); }
+				else if (e.key.keysym.scancode == SDL_SCANCODE_L) { pRenderer->ToggleTiledFrameBuffer(); }
+				else if (e.key.keysym.scancode == SDL_SCANCODE_X) { pRenderer->ToggleMultisampling(); }
+				else if (e.key.keysym.scancode == SDL_SCANCODE_G) { pRenderer->ToggleDynamicResolution(); }
+				else if (e.key.keysym.scancode == SDL_SCANCODE_K) { pRenderer->CycleShadingRate(); }
+				else if (e.key.keysym.scancode == SDL_SCANCODE_O) { pRenderer->ToggleOcclusionCulling(); }
+				else if (e.key.keysym.scancode == SDL_SCANCODE_J) { pRenderer->ToggleHiddenVehicle(); }
 				else if (e.key.keysym.scancode == SDL_SCANCODE_I)
 				{
 					SetConsoleTextAttribute(h, 6);
@@ -135,7 +163,21 @@ int main(int argc, char* args[])
 						<< "  [F5]  Cycle Shading Mode (COMBINED/OBSERVED AREA/DIFFUSE/SPECULAR)\n"
 						<< "  [F6]  Toggle NormalMap (ON/OFF)\n"
 						<< "  [F7]  Toggle DepthBuffer Visualization (ON/OFF)\n"
-						<< "  [F8]  Toggle BoundingBox Visualization (ON/OFF)\n";
+						<< "  [F8]  Toggle BoundingBox Visualization (ON/OFF)\n"
+						<< "  [T]   Toggle Tile Binning (ON/OFF)\n"
+						<< "  [H]   Toggle Hierarchical DepthBuffer (ON/OFF)\n"
+						<< "  [V]   Cycle Render Path (FORWARD/VISIBILITY BUFFER/DEPTH PREPASS)\n"
+						<< "  [R]   Cycle Raster Traversal (HIERARCHICAL/BOUNDING BOX/SCANLINE)\n"
+						<< "  [P]   Toggle Pipelined Frames (ON/OFF)\n"
+						<< "  [B]   Toggle HDR ColorBuffer (ON/OFF)\n"
+						<< "  [M]   Cycle Tone Mapping (MAX TO ONE/REINHARD/ACES)\n"
+						<< "  [Z]   Cycle Depth Format (FLOAT32/UNORM24/UNORM16/PLANE COMPRESSED)\n"
+						<< "  [L]   Toggle Tiled FrameBuffer (ON/OFF)\n"
+						<< "  [X]   Toggle MSAA 4x (ON/OFF)\n"
+						<< "  [G]   Toggle Dynamic Resolution (ON/OFF)\n"
+						<< "  [K]   Cycle Shading Rate (1X1/2X2/4X4/ADAPTIVE)\n"
+						<< "  [O]   Toggle Occlusion Culling (ON/OFF)\n"
+						<< "  [J]   Toggle Hidden Vehicle (ON/OFF)\n";
 					SetConsoleTextAttribute(h, 7);
 				}
 				else if (e.key.keysym.scancode == SDL_SCANCODE_C) { system("CLS"); }